@@ -38,19 +38,50 @@ typedef long long ssize_t;
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #endif
 
 /* for read/write buffers */
 #define READ_BUF_SIZE 1024
+#define READ_BUF_MAX (1024 * 1024)
 #define WRITE_BUF_SIZE 1024
 #define BUF_FLUSH -1
 
+/* descriptors below STREAM_MAX get an output buffer of their own */
+#define STREAM_MAX 16
+/* most strings stream_writev() takes in one call */
+#define STREAM_PARTS 8
+
 /* for command chaining */
 #define CMD_NORM 0
 #define CMD_OR 1
 #define CMD_AND 2
 #define CMD_CHAIN 3
 
+/* returned by get_input() when a compound command starts */
+#define INPUT_COMPOUND -2
+
+/* token kinds produced by the lexer */
+#define TOK_WORD 0
+#define TOK_SEMI 1
+#define TOK_AND 2
+#define TOK_OR 3
+#define TOK_PIPE 4
+#define TOK_BG 5
+#define TOK_LESS 6
+#define TOK_GREAT 7
+#define TOK_DGREAT 8
+#define TOK_DSEMI 9
+#define TOK_LPAREN 10
+#define TOK_RPAREN 11
+
+/* word token flags */
+#define TOKF_QUOTED 1 /* contains quotes or backslashes to remove */
+#define TOKF_DOLLAR 2 /* contains a '$' that may start an expansion */
+#define TOKF_DONE 4 /* quotes already removed in place, len updated */
+
 /* for convert_number() */
 #define CONVERT_LOWERCASE 1
 #define CONVERT_UNSIGNED 2
@@ -59,8 +90,32 @@ typedef long long ssize_t;
 #define USE_GETLINE 0
 #define USE_STRTOK 0
 
-#define HIST_FILE ".simple_shell_history"
+#define HIST_FILE ".simple_shell_history.bin"
+/* the text history of earlier versions, imported once */
+#define HIST_TEXT_FILE ".simple_shell_history"
+#ifndef HIST_MAX
 #define HIST_MAX 4096
+#endif
+#define HIST_BUF_SIZE (64 * 1024)
+/* the file is compacted once it holds this many times HIST_MAX records */
+#define HIST_COMPACT 2
+
+/* for job states */
+#define JOB_RUNNING 0
+#define JOB_STOPPED 1
+#define JOB_DONE 2
+
+/* initial bucket count of the command location cache */
+#define CMD_HASH_SIZE 64
+
+/* minimum size of a per-command arena block */
+#define ARENA_BLOCK_SIZE 4096
+
+/* version of the shell, also part of the key of compiled scripts */
+#define HSH_VERSION "1.0.0"
+
+/* directory under $XDG_CACHE_HOME holding compiled scripts */
+#define CODE_DIR "hsh"
 
 /* Avoid conflict with system environ */
 #ifdef WINDOWS
@@ -122,6 +177,298 @@ typedef struct liststr
     struct liststr *next;
 } list_t;
 
+/**
+ * struct token - one token of a command line
+ * @off: offset of the token in the line
+ * @len: length of the token in bytes, quotes included
+ * @kind: one of the TOK_ kinds
+ * @flags: TOKF_ flags of a word
+ */
+typedef struct token
+{
+    size_t off;
+    size_t len;
+    int kind;
+    int flags;
+} token_t;
+
+/**
+ * struct tokens - growable array of tokens
+ * @v: the tokens
+ * @n: number of tokens
+ * @cap: number of tokens allocated
+ */
+typedef struct tokens
+{
+    token_t *v;
+    size_t n;
+    size_t cap;
+} tokens_t;
+
+/**
+ * struct code_line - a line of a compiled script
+ * @tok: index of the first token of the line
+ * @ntok: number of tokens of the line
+ * @err: what lex() returned for the line
+ */
+typedef struct code_line
+{
+    size_t tok;
+    size_t ntok;
+    int err;
+} code_line_t;
+
+/**
+ * struct code - the tokens of every line of a script, see compile.c
+ * @lines: the lines, in order
+ * @nlines: number of lines
+ * @toks: the tokens of all lines, offsets relative to their line
+ * @ntoks: number of tokens
+ * @next: index of the line _getline() returns next
+ * @blob: the mapped cache file lines and toks point into, or NULL if
+ *        they were allocated
+ * @blob_len: size of the mapped cache file
+ */
+typedef struct code
+{
+    code_line_t *lines;
+    size_t nlines;
+    token_t *toks;
+    size_t ntoks;
+    size_t next;
+    char *blob;
+    size_t blob_len;
+} code_t;
+
+#ifdef WINDOWS
+/**
+ * struct iovec - one buffer of a gathered write
+ * @iov_base: the bytes
+ * @iov_len: number of bytes
+ */
+struct iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+#endif
+
+/**
+ * struct stream - output buffer of one descriptor
+ * @buf: the buffer, allocated on first use
+ * @len: number of bytes held
+ * @cap: size of buf
+ * @held: on if stream_flush_all() leaves it alone
+ */
+typedef struct stream
+{
+    char *buf;
+    size_t len;
+    size_t cap;
+    int held;
+} stream_t;
+
+/**
+ * struct hist_meta - what is known of a command in the history
+ * @start: when it started, in microseconds since the epoch, 0 if unknown
+ * @latest: the latest start of this command and of every older one
+ * @wall: how long it ran, in microseconds, -1 if unknown
+ * @cpu: CPU time of the processes it ran, in microseconds, -1 if unknown
+ * @status: its exit status, -1 if unknown
+ */
+typedef struct hist_meta
+{
+    long long start;
+    long long latest;
+    long long wall;
+    long long cpu;
+    int status;
+} hist_meta_t;
+
+typedef struct hist_index hist_index_t;
+
+/**
+ * struct history - the last HIST_MAX commands in a ring over one buffer
+ * @text: the commands, each NUL terminated and followed by the working
+ *        directory it ran in, oldest first
+ * @len: number of bytes used in text
+ * @cap: size of text
+ * @shift: number of bytes compaction has removed from the front of text
+ * @ring: HIST_MAX slots holding where each command starts, plus shift
+ * @meta: HIST_MAX slots, in step with ring, holding times and status
+ * @index: trigram index of the commands, NULL until first needed
+ * @head: slot of the oldest command
+ * @count: number of commands held
+ * @first: number shown for the oldest command
+ * @fd: the history file opened for appending, -1 if not open yet, -2 if
+ *      it cannot be opened
+ * @unsaved: number of bytes of records not yet written to the file
+ * @records: number of records in the file
+ * @off: number of bytes of the file already read or written by this shell
+ * @own_off: where this shell's last write landed, if after another's
+ * @own_len: length of that write, 0 once it has been read past
+ * @pending: 1 + number of the command line being run, 0 if none
+ * @clock: monotonic time at which that line started, in microseconds
+ * @cpu_mark: children_cpu() when the line before it ended
+ * @shared: on if other shells' commands are picked up at each prompt
+ */
+typedef struct history
+{
+    char *text;
+    size_t len;
+    size_t cap;
+    size_t shift;
+    size_t *ring;
+    hist_meta_t *meta;
+    hist_index_t *index;
+    size_t head;
+    size_t count;
+    unsigned long first;
+    int fd;
+    size_t unsaved;
+    size_t records;
+    size_t off;
+    size_t own_off;
+    size_t own_len;
+    unsigned long pending;
+    long long clock;
+    long long cpu_mark;
+    int shared;
+} history_t;
+
+/**
+ * struct arena_block - one chunk of memory of an arena_t
+ * @next: the next block
+ * @size: number of usable bytes in data
+ * @used: number of bytes handed out
+ * @data: the memory
+ */
+typedef struct arena_block
+{
+    struct arena_block *next;
+    size_t size;
+    size_t used;
+    char data[];
+} arena_block_t;
+
+/**
+ * struct arena - bump allocator for memory that lives for one command
+ * @head: the first block
+ * @cur: the block allocations are taken from
+ * @allocs: number of allocations since the last reset
+ * @bytes: number of bytes allocated since the last reset
+ * @blocks: number of blocks owned by the arena
+ */
+typedef struct arena
+{
+    arena_block_t *head;
+    arena_block_t *cur;
+    size_t allocs;
+    size_t bytes;
+    size_t blocks;
+} arena_t;
+
+/**
+ * struct var_entry - a NAME=value string kept in a var_map_t
+ * @str: the NAME=value string, NULL once the entry is deleted
+ * @hash: hash of the NAME part
+ * @keylen: length of the NAME part
+ * @vpos: position of the string in the map's vector
+ * @borrowed: 1 if str belongs to the process environment and is not freed
+ */
+typedef struct var_entry
+{
+    char *str;
+    unsigned int hash;
+    size_t keylen;
+    size_t vpos;
+    int borrowed;
+} var_entry_t;
+
+/**
+ * struct var_map - hash map of NAME=value strings keyed by NAME
+ * @entries: the entries in insertion order, deleted ones included
+ * @count: number of entries used, deleted ones included
+ * @live: number of entries not deleted
+ * @cap: number of entries allocated
+ * @slots: open addressing index of entry positions
+ * @nslots: number of index slots, a power of two
+ * @vec: NULL terminated vector of the live strings, usable as envp
+ * @vec_cap: number of vector elements allocated
+ */
+typedef struct var_map
+{
+    var_entry_t *entries;
+    size_t count;
+    size_t live;
+    size_t cap;
+    int *slots;
+    size_t nslots;
+    char **vec;
+    size_t vec_cap;
+} var_map_t;
+
+/**
+ * struct cmd_hash_entry - cached location of a command
+ * @name: the command name as typed
+ * @path: the resolved path, or NULL if the name was not found in PATH
+ * @hits: number of lookups answered by this entry
+ * @next: next entry in the same bucket
+ */
+typedef struct cmd_hash_entry
+{
+    char *name;
+    char *path;
+    unsigned int hits;
+    struct cmd_hash_entry *next;
+} cmd_hash_entry_t;
+
+/**
+ * struct cmd_hash - per-shell command location cache
+ * @buckets: array of bucket chains
+ * @size: number of buckets
+ * @count: number of cached entries, negative ones included
+ * @hits: lookups answered from the cache
+ * @misses: lookups that had to search PATH
+ */
+typedef struct cmd_hash
+{
+    cmd_hash_entry_t **buckets;
+    unsigned int size;
+    unsigned int count;
+    unsigned long hits;
+    unsigned long misses;
+} cmd_hash_t;
+
+/**
+ * struct job - a background job
+ * @id: the job number shown by jobs
+ * @pgid: process group of the job
+ * @pids: pids of the job's processes, last pipeline stage last
+ * @status: exit status of each process, -1 while it is running
+ * @nprocs: number of processes
+ * @nlive: number of processes not yet reaped
+ * @state: JOB_RUNNING, JOB_STOPPED or JOB_DONE
+ * @exit: exit status of the job once it is done
+ * @notified: 0 if a state change has not been reported yet
+ * @cmd: the command line of the job
+ * @next: the next job
+ */
+typedef struct job
+{
+    int id;
+    pid_t pgid;
+    pid_t *pids;
+    int *status;
+    int nprocs;
+    int nlive;
+    int state;
+    int exit;
+    int notified;
+    char *cmd;
+    struct job *next;
+} job_t;
+
 /**
  *struct passinfo - contains pseudo-arguements to pass into a function,
  *		allowing uniform prototype for function pointer struct
@@ -133,16 +480,36 @@ typedef struct liststr
  *@err_num: the error code for exit()s
  *@linecount_flag: if on count this line of input
  *@fname: the program filename
- *@env: linked list local copy of environ
- *@env_array: custom modified copy of environ from LL env
- *@history: the history node
- *@alias: the alias node
+ *@env: hash map local copy of environ
+ *@history: the most recent commands
+ *@alias: hash map of NAME=value alias definitions
  *@env_changed: on if environ was changed
  *@status: the return status of the last exec'd command
  *@cmd_buf: address of pointer to cmd_buf, on if chaining
  *@cmd_buf_type: CMD_type ||, &&, ;
  *@readfd: the fd from which to read line input
- *@histcount: the history line number count
+ *@cmd_hash: cache of resolved command locations
+ *@pipestatus: exit status of each stage of the last pipeline
+ *@pipe_len: number of stages of the last pipeline, 0 if it was not one
+ *@background: on if the current command ends with '&'
+ *@jobs: the background job table
+ *@sigchld_set: on once the SIGCHLD handler is installed
+ *@last_bg_pid: pid of the last background job, for $!
+ *@alias_cache: fully expanded alias values, cleared when an alias changes
+ *@arena: holds argv and expansions of the current command
+ *@tokens: the tokens of the current line
+ *@tok_base: the line the token offsets refer to
+ *@tok_start: index of the first token of the current command
+ *@tok_end: index one past the last token of the current command
+ *@redir_in: file to redirect stdin from, or NULL
+ *@redir_out: file to redirect stdout to, or NULL
+ *@redir_append: on if redir_out is opened for appending
+ *@map: the script file mapped into memory, or NULL to read readfd
+ *@map_len: size of the mapping
+ *@map_pos: offset of the next line in the mapping
+ *@code: the compiled form of the mapped script, if any
+ *@map_borrowed: on if map is a -c string rather than a mapped file
+ *@tty: on if commands are read from a terminal, checked once at startup
  */
 typedef struct passinfo
 {
@@ -154,44 +521,113 @@ typedef struct passinfo
     int err_num;
     int linecount_flag;
     char *fname;
-    list_t *env;
-    list_t *history;
-    list_t *alias;
-    char **env_array; /* Renamed from environ to avoid conflict */
+    var_map_t env;
+    history_t history;
+    var_map_t alias;
     int env_changed;
     int status;
 
     char **cmd_buf;   /* pointer to cmd ; chain buffer, for memory mangement */
     int cmd_buf_type; /* CMD_type ||, &&, ; */
     int readfd;
-    int histcount;
+    cmd_hash_t cmd_hash;
+    int *pipestatus;
+    int pipe_len;
+    int background;
+    job_t *jobs;
+    int sigchld_set;
+    pid_t last_bg_pid;
+    var_map_t alias_cache;
+    arena_t arena;
+    tokens_t tokens;
+    char *tok_base;
+    size_t tok_start;
+    size_t tok_end;
+    char *redir_in;
+    char *redir_out;
+    int redir_append;
+    char *map;
+    size_t map_len;
+    size_t map_pos;
+    code_t code;
+    int map_borrowed;
+    int tty;
 } info_t;
 
 #define INFO_INIT                                                            \
-    {NULL, NULL, NULL, 0, 0, 0, 0, NULL, NULL, NULL, NULL, NULL, 0, 0, NULL, \
-     0, 0, 0}
+    {NULL, NULL, NULL, 0, 0, 0, 0, NULL,                                     \
+     {NULL, 0, 0, 0, NULL, 0, NULL, 0},                                      \
+     {NULL, 0, 0, 0, NULL, NULL, NULL, 0, 0, 0, -1, 0, 0, 0, 0, 0, 0, 0,     \
+      0, 0},                                                                 \
+     {NULL, 0, 0, 0, NULL, 0, NULL, 0}, 0, 0, NULL, 0, 0,                    \
+     {NULL, 0, 0, 0, 0}, NULL, 0, 0, NULL, 0, 0,                             \
+     {NULL, 0, 0, 0, NULL, 0, NULL, 0}, {NULL, NULL, 0, 0, 0},               \
+     {NULL, 0, 0}, NULL, 0, 0, NULL, NULL, 0, NULL, 0, 0,                    \
+     {NULL, 0, NULL, 0, 0, NULL, 0}, 0, 0}
 
 /**
  *struct builtin - contains a builtin string and related function
  *@type: the builtin command flag
  *@func: the function
+ *@desc: one line description shown by help
  */
 typedef struct builtin
 {
     char *type;
     int (*func)(info_t *);
+    char *desc;
 } builtin_table;
 
 /* toem_shloop.c */
 int hsh(info_t *, char **);
+int run_command(info_t *);
 int find_builtin(info_t *);
+int (*get_builtin(char *))(info_t *);
+const builtin_table *builtin_list(void);
 void find_cmd(info_t *);
 void fork_cmd(info_t *);
 
+/* toem_spawn.c */
+#ifndef WINDOWS
+int spawn_cmd(info_t *, char *, char **, int [3], pid_t, pid_t *);
+int wait_cmd(info_t *, pid_t);
+int exit_status(int);
+void spawn_error(info_t *, int);
+#endif
+
+/* toem_pipeline.c */
+int is_pipeline(info_t *);
+#ifndef WINDOWS
+void run_pipeline(info_t *);
+#endif
+
+/* toem_jobs.c */
+#ifndef WINDOWS
+pid_t wait_child(pid_t, int *, int);
+long long children_cpu(void);
+job_t *job_add(info_t *, pid_t *, int, pid_t, char *);
+job_t *job_find(info_t *, char *);
+void job_remove(info_t *, job_t *);
+int job_wait(info_t *, job_t *);
+void jobs_reap(info_t *);
+void jobs_notify(info_t *);
+void jobs_free(info_t *);
+int _myjobs(info_t *);
+int _mywait(info_t *);
+int _myfg(info_t *);
+int _mybg(info_t *);
+#endif
+
+/* toem_parallel.c */
+#ifndef WINDOWS
+int _myparallel(info_t *);
+#endif
+
 /* toem_parser.c */
 int is_cmd(info_t *, char *);
 char *dup_chars(char *, int, int);
 char *find_path(info_t *, char *, char *);
+char *resolve_cmd(info_t *, char *);
 
 /* loophsh.c */
 int loophsh(char **);
@@ -201,6 +637,8 @@ void _eputs(char *);
 int _eputchar(char);
 int _putfd(char c, int fd);
 int _putsfd(char *str, int fd);
+size_t _eputsn(const char *, size_t);
+size_t _putfdn(const char *, size_t, int);
 
 /* toem_string.c */
 int _strlen(char *);
@@ -212,6 +650,7 @@ char *_strcat(char *, char *);
 char *_strcpy(char *, char *);
 char *shell_strdup(const char *); /* Renamed from _strdup to avoid conflict */
 void _puts(char *);
+size_t _putsn(const char *, size_t);
 int _putchar(char);
 
 /* toem_exits.c */
@@ -220,7 +659,7 @@ char *_strncat(char *, char *, int);
 char *_strchr(char *, char);
 
 /* toem_tokenizer.c */
-char **strtow(char *, char *);
+char **strtow(arena_t *, char *, char *);
 char **strtow2(char *, char);
 
 /* toem_realloc.c */
@@ -242,7 +681,6 @@ int _erratoi(char *);
 void print_error(info_t *, char *);
 int print_d(int, int);
 char *convert_number(long int, int, int);
-void remove_comments(char *);
 
 /* toem_builtin.c */
 int _myexit(info_t *);
@@ -257,12 +695,24 @@ int _mytest(info_t *); /* Test command for UTF-8 and Arabic */
 
 /*toem_getline.c */
 ssize_t get_input(info_t *);
-int _getline(info_t *, char **, size_t *);
+ssize_t get_more(info_t *);
+ssize_t _getline(info_t *, char **, size_t *);
+void map_input(info_t *);
+void unmap_input(info_t *);
 void sigintHandler(int);
+int sigint_pending(void);
+
+/* toem_compile.c */
+#ifndef WINDOWS
+int code_load(info_t *, char *);
+int code_compile(info_t *, char *);
+void code_free(code_t *);
+#endif
+int code_tokens(info_t *, size_t);
 
 /* toem_getinfo.c */
 void clear_info(info_t *);
-void set_info(info_t *, char **);
+int set_info(info_t *);
 void free_info(info_t *, int);
 
 /* toem_environ.c */
@@ -273,7 +723,7 @@ int _myunsetenv(info_t *);
 int populate_env_list(info_t *);
 
 /* toem_getenv.c */
-char **get_environ(info_t *);
+char **get_environ_copy(info_t *);
 int _unsetenv(info_t *, char *);
 int _setenv(info_t *, char *, char *);
 
@@ -281,8 +731,54 @@ int _setenv(info_t *, char *, char *);
 char *get_history_file(info_t *info);
 int write_history(info_t *info);
 int read_history(info_t *info);
-int build_history_list(info_t *info, char *buf, int linecount);
-int renumber_history(info_t *info);
+int build_history_list(info_t *info, char *buf);
+int hist_save(info_t *);
+void hist_sync(info_t *);
+void hist_end(info_t *, int);
+int hist_add(history_t *, const char *, const char *, const hist_meta_t *);
+char *hist_get(history_t *, size_t);
+hist_meta_t *hist_meta(history_t *, size_t);
+void hist_free(history_t *);
+
+/* toem_history_query.c */
+int hist_query(info_t *, long long, int, size_t);
+
+/* toem_history_index.c */
+void hist_index_add(history_t *, size_t);
+int hist_index_build(history_t *);
+void hist_index_free(hist_index_t *);
+ssize_t hist_search(info_t *, char *);
+
+/* toem_stream.c */
+void stream_setbuf(int, size_t);
+void stream_hold(int);
+size_t stream_write(int, const char *, size_t);
+size_t stream_writev(int, const char **, int);
+void stream_flush(int);
+void stream_flush_all(void);
+
+/* toem_arena.c */
+void *arena_alloc(arena_t *, size_t);
+char *arena_strdup(arena_t *, const char *);
+void arena_reset(arena_t *);
+void arena_free(arena_t *);
+void arena_report(arena_t *);
+
+/* toem_varmap.c */
+var_entry_t *varmap_find(var_map_t *, const char *, size_t);
+int varmap_set(var_map_t *, char *);
+int varmap_import(var_map_t *, char **);
+int varmap_unset(var_map_t *, const char *, size_t);
+void varmap_free(var_map_t *);
+size_t varmap_print(var_map_t *);
+char **varmap_vector(var_map_t *);
+
+/* toem_hash.c */
+char *hash_find_path(info_t *, char *);
+int hash_add(info_t *, char *);
+void hash_reset(info_t *);
+void hash_free(info_t *);
+int _myhash(info_t *);
 
 /* toem_lists.c */
 list_t *add_node(list_t **, const char *, int);
@@ -299,11 +795,27 @@ list_t *node_starts_with(list_t *, char *, char);
 ssize_t get_node_index(list_t *, list_t *);
 
 /* toem_vars.c */
-int is_chain(info_t *, char *, size_t *);
-void check_chain(info_t *, char *, size_t *, size_t, size_t);
-int replace_alias(info_t *);
-int replace_vars(info_t *);
-int replace_string(char **, char *);
+char *alias_value(info_t *, char *);
+const char *var_value(info_t *, const char *, size_t);
+char *pipestatus_string(info_t *);
+
+/* toem_lexer.c */
+int lex(char *, tokens_t *);
+char *tok_word(info_t *, char *, token_t *);
+void syntax_error(info_t *, char *);
+char *tok_unexpected(token_t *);
+
+/* toem_control.c */
+int keyword(char *, token_t *);
+int run_compound(info_t *);
+
+#ifndef WINDOWS
+/* toem_redirect.c */
+int redir_open(info_t *, int [3]);
+void redir_close(int [3]);
+int redir_push(info_t *, int [3]);
+void redir_pop(int [3]);
+#endif
 
 /* UTF-8 and Arabic support functions */
 int get_utf8_char_length(char first_byte);
@@ -313,6 +825,8 @@ int utf8_to_codepoint(char *utf8_char, int length);
 int codepoint_to_utf8(int codepoint, char *utf8_char);
 void configure_terminal_for_utf8(void);
 int set_text_direction(int is_rtl);
+size_t utf8_ascii_len(const char *, size_t);
+size_t utf8_valid_len(const char *, size_t);
 
 /* UTF-8 output functions */
 void _puts_utf8(char *str);
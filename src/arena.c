@@ -0,0 +1,118 @@
+#include "shell.h"
+
+/* allocations are rounded up to this size so any type can be stored */
+#define ARENA_ALIGN 16
+
+/**
+ * arena_alloc - allocates memory that lives until the arena is reset
+ * @arena: the arena
+ * @size: number of bytes
+ *
+ * Memory is carved from the current block by bumping an offset. Blocks
+ * are kept across resets, so a steady workload stops calling malloc().
+ *
+ * Return: the memory, or NULL on allocation failure
+ */
+void *arena_alloc(arena_t *arena, size_t size)
+{
+    arena_block_t *b = arena->cur;
+    size_t bsize;
+    void *p;
+
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    while (b && b->used + size > b->size)
+    {
+        b = b->next;
+        if (b)
+            b->used = 0;
+    }
+    if (!b)
+    {
+        bsize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        b = malloc(sizeof(arena_block_t) + bsize);
+        if (!b)
+            return (NULL);
+        b->size = bsize;
+        b->used = 0;
+        b->next = NULL;
+        if (arena->cur)
+        {
+            b->next = arena->cur->next;
+            arena->cur->next = b;
+        }
+        else
+            arena->head = b;
+        arena->blocks++;
+    }
+    arena->cur = b;
+    p = b->data + b->used;
+    b->used += size;
+    arena->allocs++;
+    arena->bytes += size;
+    return (p);
+}
+
+/**
+ * arena_strdup - copies a string into an arena
+ * @arena: the arena
+ * @str: the string
+ *
+ * Return: the copy, or NULL on allocation failure
+ */
+char *arena_strdup(arena_t *arena, const char *str)
+{
+    size_t len = _strlen((char *)str);
+    char *p = arena_alloc(arena, len + 1);
+
+    if (p)
+        memcpy(p, str, len + 1);
+    return (p);
+}
+
+/**
+ * arena_reset - releases everything allocated from an arena at once
+ * @arena: the arena
+ *
+ * The blocks are kept for reuse; only the first one is rewound here,
+ * later ones are rewound as arena_alloc() reaches them.
+ */
+void arena_reset(arena_t *arena)
+{
+    arena->cur = arena->head;
+    if (arena->head)
+        arena->head->used = 0;
+    arena->allocs = 0;
+    arena->bytes = 0;
+}
+
+/**
+ * arena_free - frees every block of an arena
+ * @arena: the arena
+ */
+void arena_free(arena_t *arena)
+{
+    arena_block_t *b, *next;
+
+    for (b = arena->head; b; b = next)
+    {
+        next = b->next;
+        free(b);
+    }
+    arena->head = arena->cur = NULL;
+    arena->allocs = arena->bytes = arena->blocks = 0;
+}
+
+/**
+ * arena_report - prints the allocation counters of an arena to stderr
+ * @arena: the arena
+ */
+void arena_report(arena_t *arena)
+{
+    _eputs("arena: ");
+    _eputs(convert_number(arena->allocs, 10, 0));
+    _eputs(" allocs, ");
+    _eputs(convert_number(arena->bytes, 10, 0));
+    _eputs(" bytes, ");
+    _eputs(convert_number(arena->blocks, 10, 0));
+    _eputs(" blocks\n");
+}
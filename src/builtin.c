@@ -40,7 +40,7 @@ int _mycd(info_t *info)
     char *s, *dir, buffer[1024];
     int chdir_ret;
 
-    s = _getcwd(buffer, 1024);
+    s = getcwd(buffer, 1024);
     if (!s)
         _puts("TODO: >>getcwd failure emsg here<<\n");
     if (!info->argv[1])
@@ -74,7 +74,7 @@ int _mycd(info_t *info)
     else
     {
         _setenv(info, "OLDPWD", _getenv(info, "PWD="));
-        _setenv(info, "PWD", _getcwd(buffer, 1024));
+        _setenv(info, "PWD", getcwd(buffer, 1024));
     }
     return (0);
 }
@@ -88,21 +88,23 @@ int _mycd(info_t *info)
 int _myhelp(info_t *info)
 {
     char **arg_array;
+    const builtin_table *tbl;
+    int i;
 
     arg_array = info->argv;
     if (info->argc == 1)
     {
         _puts("Help menu - type 'help' followed by a command for more info.\n");
-        _puts("  cd       - Change directory\n");
-        _puts("  exit     - Exit the shell\n");
-        _puts("  env      - Show environment variables\n");
-        _puts("  setenv   - Set environment variable\n");
-        _puts("  unsetenv - Remove environment variable\n");
-        _puts("  help     - Display help information\n");
-        _puts("  history  - Show command history\n");
-        _puts("  alias    - Manage command aliases\n");
-        _puts("  lang     - Change shell language\n");
-        _puts("  test     - Test UTF-8 and Arabic support\n");
+        for (tbl = builtin_list(); tbl->type; tbl++)
+        {
+            _puts("  ");
+            _puts(tbl->type);
+            for (i = _strlen(tbl->type); i < 9; i++)
+                _putchar(' ');
+            _puts("- ");
+            _puts(tbl->desc);
+            _putchar('\n');
+        }
         return (0);
     }
     if (_strcmp(arg_array[1], "cd") == 0)
@@ -143,8 +145,16 @@ int _myhelp(info_t *info)
     }
     else if (_strcmp(arg_array[1], "history") == 0)
     {
-        _puts("history: history\n");
+        _puts("history: history [--since TIME] [--failed] [--slowest N]\n");
         _puts("    Display the command history list with line numbers.\n");
+        _puts("    --since shows the commands started since TIME, given as\n");
+        _puts("    @SECONDS since the epoch or as Ns, Nm, Nh or Nd ago;\n");
+        _puts("    --failed those that exited with a non-zero status;\n");
+        _puts("    --slowest the N that ran longest. These also show the\n");
+        _puts("    start time, wall and CPU time, status and directory.\n");
+        _puts("history: history -s PATTERN\n");
+        _puts("    Display the commands containing PATTERN, those equal to\n");
+        _puts("    it first, then the others, newest first.\n");
     }
     else if (_strcmp(arg_array[1], "alias") == 0)
     {
@@ -169,6 +179,49 @@ int _myhelp(info_t *info)
         _puts("    Displays various test patterns including ASCII, UTF-8,\n");
         _puts("    Arabic text, mixed text direction, and Arabic numbers.\n");
     }
+    else if (_strcmp(arg_array[1], "hash") == 0)
+    {
+        _puts("hash: hash [-rs] [NAME ...]\n");
+        _puts("    Remember the full pathname of each NAME.\n");
+        _puts("    Without arguments, lists the remembered commands and their hit counts.\n");
+        _puts("    -r forgets every remembered location, -s prints cache statistics.\n");
+        _puts("    The cache is reset whenever PATH is changed.\n");
+    }
+    else if (_strcmp(arg_array[1], "jobs") == 0)
+    {
+        _puts("jobs: jobs [-l]\n");
+        _puts("    List the background jobs and their state.\n");
+        _puts("    -l also shows the process group of each job.\n");
+    }
+    else if (_strcmp(arg_array[1], "wait") == 0)
+    {
+        _puts("wait: wait [-n] [%JOB | PID ...]\n");
+        _puts("    Wait for background jobs and return the status of the last one.\n");
+        _puts("    Without arguments, waits for every job.\n");
+        _puts("    -n waits for the next job to finish.\n");
+    }
+    else if (_strcmp(arg_array[1], "fg") == 0)
+    {
+        _puts("fg: fg [%JOB]\n");
+        _puts("    Resume JOB in the foreground and wait for it.\n");
+        _puts("    Without arguments, uses the most recent job.\n");
+    }
+    else if (_strcmp(arg_array[1], "bg") == 0)
+    {
+        _puts("bg: bg [%JOB]\n");
+        _puts("    Resume the stopped JOB in the background.\n");
+        _puts("    Without arguments, uses the most recent job.\n");
+    }
+    else if (_strcmp(arg_array[1], "parallel") == 0)
+    {
+        _puts("parallel: parallel [-j N] [-k] [-a FILE] COMMAND [ARGS...]\n");
+        _puts("    Run COMMAND once for each line read from stdin or FILE.\n");
+        _puts("    {} in ARGS is replaced by the line, otherwise it is appended.\n");
+        _puts("    -j N runs N jobs at a time (default: number of online CPUs).\n");
+        _puts("    -k, --keep-order writes job output in input order.\n");
+        _puts("    The output of each job is written in one piece when it finishes.\n");
+        _puts("    Exit status is the number of failed jobs, at most 101.\n");
+    }
     else
     {
         _puts("No help available for this command.\n");
@@ -249,11 +302,11 @@ int _mytest(info_t *info)
     _puts("Text Direction Test:\n");
     
     /* Force LTR */
-    write(STDOUT_FILENO, "\xE2\x80\x8E", 3); /* LTR mark (U+200E) */
+    _putsn("\xE2\x80\x8E", 3); /* LTR mark (U+200E) */
     _puts_utf8("LTR: Hello مرحبا بالعالم World!\n");
     
     /* Force RTL */
-    write(STDOUT_FILENO, "\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
+    _putsn("\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
     _puts_utf8("RTL: Hello مرحبا بالعالم World!\n");
     
     return (0);
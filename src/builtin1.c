@@ -1,39 +1,100 @@
 #include "shell.h"
+#include <time.h>
+
+/**
+ * parse_since - reads the time given to history --since
+ * @s: @SECONDS since the epoch, or a number followed by s, m, h or d for
+ *     that many seconds, minutes, hours or days ago
+ * @us: where to store the time, in microseconds since the epoch
+ *
+ * Return: 0 on success, -1 if s is not a time
+ */
+static int parse_since(char *s, long long *us)
+{
+	long long n = 0, unit = 1;
+	int at = *s == '@';
+	char *p = s + at;
+
+	for (; *p >= '0' && *p <= '9' && n < 1000000000000LL; p++)
+		n = n * 10 + (*p - '0');
+	if (p == s + at)
+		return (-1);
+	if (!at && *p)
+		unit = *p == 's' ? 1 : *p == 'm' ? 60 : *p == 'h' ? 3600
+			: *p == 'd' ? 86400 : 0, p++;
+	if (*p || !unit)
+		return (-1);
+	*us = (at ? n : (long long)time(NULL) - n * unit) * 1000000;
+	return (0);
+}
 
 /**
  * _myhistory - displays the history list, one command by line, preceded
  *              with line numbers, starting at 0.
  * @info: Structure containing potential arguments. Used to maintain
  *        constant function prototype.
- *  Return: Always 0
+ *
+ * With --since TIME, --failed or --slowest N only the matching commands
+ * are shown, along with when they started, how long they ran, the CPU
+ * time they used, their exit status and their working directory. With
+ * -s PATTERN only the commands containing PATTERN are shown, those equal
+ * to it first, newest first.
+ *
+ *  Return: 0 on success, 1 on error or if -s matched nothing
  */
 int _myhistory(info_t *info)
 {
-	print_list(info->history);
+	const char *parts[] = {NULL, ": ", NULL, "\n"};
+	char **av = info->argv + 1;
+	long long since = 0;
+	size_t i, slowest = 0;
+	int failed = 0, query = 0;
+
+	if (*av && !_strcmp(*av, "-s") && av[1] && !av[2])
+		return (info->status = hist_search(info, av[1]) <= 0);
+	for (; *av; av++, query = 1)
+	{
+		if (!_strcmp(*av, "--failed"))
+			failed = 1;
+		else if (!_strcmp(*av, "--since") && av[1]
+				&& !parse_since(av[1], &since))
+			av++;
+		else if (!_strcmp(*av, "--slowest") && av[1] && _erratoi(av[1]) > 0)
+			slowest = _erratoi(*++av);
+		else
+		{
+			info->status = 2;
+			print_error(info, "usage: history [--since TIME] [--failed]");
+			_eputs(" [--slowest N]\n       history -s PATTERN\n");
+			return (1);
+		}
+	}
+	if (query)
+		return (hist_query(info, since, failed, slowest) == -1);
+	for (i = 0; (parts[2] = hist_get(&(info->history), i)); i++)
+	{
+		parts[0] = convert_number(info->history.first + i, 10, 0);
+		stream_writev(STDOUT_FILENO, parts, 4);
+	}
 	return (0);
 }
 
 /**
- * unset_alias - sets alias to string
+ * unset_alias - removes an alias
  * @info: parameter struct
- * @str: the string alias
+ * @str: the string alias, NAME=...
  *
- * Return: Always 0 on success, 1 on error
+ * Return: 0 if the alias was removed, 1 otherwise
  */
 int unset_alias(info_t *info, char *str)
 {
-	char *p, c;
-	int ret;
+	char *p;
 
 	p = _strchr(str, '=');
 	if (!p)
 		return (1);
-	c = *p;
-	*p = 0;
-	ret = delete_node_at_index(&(info->alias),
-		get_node_index(info->alias, node_starts_with(info->alias, str, -1)));
-	*p = c;
-	return (ret);
+	varmap_free(&(info->alias_cache));
+	return (!varmap_unset(&(info->alias), str, p - str));
 }
 
 /**
@@ -53,24 +114,32 @@ int set_alias(info_t *info, char *str)
 	if (!*++p)
 		return (unset_alias(info, str));
 
-	unset_alias(info, str);
-	return (add_node_end(&(info->alias), str, 0) == NULL);
+	varmap_free(&(info->alias_cache));
+	p = shell_strdup(str);
+	if (!p)
+		return (1);
+	if (varmap_set(&(info->alias), p) == -1)
+	{
+		free(p);
+		return (1);
+	}
+	return (0);
 }
 
 /**
  * print_alias - prints an alias string
- * @node: the alias node
+ * @str: the NAME=value alias string
  *
  * Return: Always 0 on success, 1 on error
  */
-int print_alias(list_t *node)
+int print_alias(char *str)
 {
 	char *p = NULL, *a = NULL;
 
-	if (node)
+	if (str)
 	{
-		p = _strchr(node->str, '=');
-		for (a = node->str; a <= p; a++)
+		p = _strchr(str, '=');
+		for (a = str; a <= p; a++)
 			_putchar(*a);
 		_putchar('\'');
 		_puts(p + 1);
@@ -89,17 +158,14 @@ int print_alias(list_t *node)
 int _myalias(info_t *info)
 {
 	int i = 0;
+	size_t k;
 	char *p = NULL;
-	list_t *node = NULL;
+	var_entry_t *e;
 
 	if (info->argc == 1)
 	{
-		node = info->alias;
-		while (node)
-		{
-			print_alias(node);
-			node = node->next;
-		}
+		for (k = 0; k < info->alias.count; k++)
+			print_alias(info->alias.entries[k].str);
 		return (0);
 	}
 	for (i = 1; info->argv[i]; i++)
@@ -108,7 +174,11 @@ int _myalias(info_t *info)
 		if (p)
 			set_alias(info, info->argv[i]);
 		else
-			print_alias(node_starts_with(info->alias, info->argv[i], '='));
+		{
+			e = varmap_find(&(info->alias), info->argv[i],
+				_strlen(info->argv[i]));
+			print_alias(e ? e->str : NULL);
+		}
 	}
 
 	return (0);
@@ -0,0 +1,424 @@
+#include "shell.h"
+#include <stddef.h>
+
+/*
+ * A compiled script is the lexer's output for every line of a script,
+ * cached in $XDG_CACHE_HOME/hsh so later runs can skip lexing. The cache
+ * file is a code_header_t, the script path padded to CODE_ALIGN, the
+ * code_line_t array and the token_t array, in the native layout. It is
+ * keyed by path, mtime, size and HSH_VERSION; anything that does not
+ * match is ignored and rebuilt. Expansions and aliases depend on the
+ * state of the shell when a line runs, so they are not compiled.
+ */
+#define CODE_MAGIC 0x43485348 /* "HSHC" */
+#define CODE_FORMAT 2
+#define CODE_ALIGN 16
+
+/**
+ * struct code_header - the start of a compiled script file
+ * @magic: CODE_MAGIC
+ * @format: CODE_FORMAT
+ * @version: HSH_VERSION
+ * @mtime_sec: mtime of the script, seconds
+ * @mtime_nsec: mtime of the script, nanoseconds
+ * @size: size of the script
+ * @path_len: length of the script path that follows the header
+ * @nlines: number of lines
+ * @ntoks: number of tokens
+ */
+typedef struct code_header
+{
+    unsigned int magic;
+    unsigned int format;
+    char version[16];
+    long long mtime_sec;
+    long long mtime_nsec;
+    long long size;
+    size_t path_len;
+    size_t nlines;
+    size_t ntoks;
+} code_header_t;
+
+/**
+ * code_tokens - sets the tokens of the current line from the script code
+ * @info: parameter struct
+ * @len: length of the line, whose text is at info->tok_base
+ *
+ * Return: what lex() would have returned for the line
+ */
+int code_tokens(info_t *info, size_t len)
+{
+    code_t *code = &(info->code);
+    code_line_t *l;
+    token_t *v, *t;
+    size_t k;
+
+    /* the cache file is not trusted: bounds are checked without sums */
+    l = code->next < code->nlines ? &code->lines[code->next] : NULL;
+    if (!l || l->tok > code->ntoks || l->ntok > code->ntoks - l->tok
+            || l->err < -2 || l->err > 0)
+        return (lex(info->tok_base, &(info->tokens)));
+    code->next++;
+    info->tokens.n = 0;
+    if (l->err)
+        return (l->err);
+    if (l->ntok > info->tokens.cap)
+    {
+        v = realloc(info->tokens.v, sizeof(token_t) * l->ntok);
+        if (!v)
+            return (-2);
+        info->tokens.v = v;
+        info->tokens.cap = l->ntok;
+    }
+    for (k = 0; k < l->ntok; k++)
+    {
+        t = &code->toks[l->tok + k];
+        if (t->off > len || t->len > len - t->off
+                || (unsigned int)t->kind > TOK_RPAREN
+                || t->flags & ~(TOKF_QUOTED | TOKF_DOLLAR))
+            return (lex(info->tok_base, &(info->tokens)));
+    }
+    memcpy(info->tokens.v, code->toks + l->tok, sizeof(token_t) * l->ntok);
+    info->tokens.n = l->ntok;
+    return (0);
+}
+
+#ifndef WINDOWS
+/**
+ * code_pad - rounds a size up to CODE_ALIGN
+ * @n: the size
+ *
+ * Return: the rounded size
+ */
+static size_t code_pad(size_t n)
+{
+    return ((n + CODE_ALIGN - 1) & ~(size_t)(CODE_ALIGN - 1));
+}
+
+/**
+ * code_header - fills in the header a script compiles to
+ * @h: the header
+ * @st: status of the script
+ * @path: absolute path of the script
+ */
+static void code_header(code_header_t *h, struct stat *st, char *path)
+{
+    _memset((char *)h, 0, sizeof(*h));
+    h->magic = CODE_MAGIC;
+    h->format = CODE_FORMAT;
+    _strcpy(h->version, HSH_VERSION);
+    h->mtime_sec = st->st_mtim.tv_sec;
+    h->mtime_nsec = st->st_mtim.tv_nsec;
+    h->size = st->st_size;
+    h->path_len = _strlen(path);
+}
+
+/**
+ * code_file - builds the name of the cache file of a script
+ * @info: parameter struct
+ * @path: absolute path of the script
+ * @mkdirs: on to create the cache directory if needed
+ *
+ * Return: allocated file name, or NULL if there is no cache directory
+ */
+static char *code_file(info_t *info, char *path, int mkdirs)
+{
+    char *dir = _getenv(info, "XDG_CACHE_HOME="), *home = NULL, *buf;
+    unsigned long long h = 14695981039346656037ULL;
+    size_t n;
+    int i;
+
+    for (; *path; path++)
+        h = (h ^ (unsigned char)*path) * 1099511628211ULL;
+    if (!dir || *dir != '/')
+    {
+        home = _getenv(info, "HOME=");
+        if (!home)
+            return (NULL);
+    }
+    n = _strlen(home ? home : dir);
+    buf = malloc(n + sizeof("/.cache/" CODE_DIR "/") + 16 + 6);
+    if (!buf)
+        return (NULL);
+    _strcpy(buf, home ? home : dir);
+    if (home)
+        _strcat(buf, "/.cache");
+    if (mkdirs)
+        mkdir(buf, 0700);
+    _strcat(buf, "/" CODE_DIR);
+    if (mkdirs)
+        mkdir(buf, 0700);
+    _strcat(buf, "/");
+    n = _strlen(buf);
+    for (i = 60; i >= 0; i -= 4)
+        buf[n++] = "0123456789abcdef"[(h >> i) & 15];
+    _strcpy(buf + n, ".hshc");
+    return (buf);
+}
+
+/**
+ * code_build - lexes every line of the mapped script
+ * @info: parameter struct
+ *
+ * Lines are split exactly as map_getline() splits them.
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int code_build(info_t *info)
+{
+    code_t *code = &(info->code);
+    tokens_t tl = {NULL, 0, 0};
+    char *s = info->map, *nl, *line = NULL, *grown;
+    size_t pos = 0, k, lcap = 0, ncap = 0, tcap = 0;
+    code_line_t *l;
+    token_t *t;
+
+    while (pos < info->map_len)
+    {
+        nl = memchr(s + pos, '\n', info->map_len - pos);
+        k = nl ? (size_t)(nl - (s + pos)) : info->map_len - pos;
+        if (k + 1 > lcap)
+        {
+            lcap = (k + 1) * 2;
+            grown = realloc(line, lcap);
+            if (!grown)
+                goto fail;
+            line = grown;
+        }
+        memcpy(line, s + pos, k);
+        line[k] = 0;
+        pos += k + (nl != NULL);
+        if (code->nlines == ncap)
+        {
+            ncap = ncap ? ncap * 2 : 64;
+            l = realloc(code->lines, sizeof(code_line_t) * ncap);
+            if (!l)
+                goto fail;
+            code->lines = l;
+        }
+        l = &code->lines[code->nlines++];
+        l->err = lex(line, &tl);
+        if (l->err == -2)
+            goto fail;
+        l->tok = code->ntoks;
+        l->ntok = l->err ? 0 : tl.n;
+        if (code->ntoks + l->ntok > tcap)
+        {
+            tcap = tcap ? tcap * 2 : 256;
+            while (tcap < code->ntoks + l->ntok)
+                tcap *= 2;
+            t = realloc(code->toks, sizeof(token_t) * tcap);
+            if (!t)
+                goto fail;
+            code->toks = t;
+        }
+        memcpy(code->toks + code->ntoks, tl.v, sizeof(token_t) * l->ntok);
+        code->ntoks += l->ntok;
+    }
+    free(line);
+    free(tl.v);
+    return (0);
+fail:
+    free(line);
+    free(tl.v);
+    code_free(code);
+    return (-1);
+}
+
+/**
+ * code_write - saves the code of a script to its cache file
+ * @code: the code
+ * @h: the header of the code
+ * @path: absolute path of the script
+ * @file: the cache file
+ *
+ * The file is written under a temporary name and renamed into place, so
+ * a concurrent run never sees it half written.
+ *
+ * Return: 0 on success, -1 on failure
+ */
+static int code_write(code_t *code, code_header_t *h, char *path, char *file)
+{
+    char *tmp = malloc(_strlen(file) + 24), *pid, pad[CODE_ALIGN] = {0};
+    size_t plen = code_pad(h->path_len) - h->path_len;
+    int fd, ok;
+
+    if (!tmp)
+        return (-1);
+    pid = convert_number(getpid(), 10, 0);
+    _strcpy(tmp, file);
+    _strcat(tmp, ".");
+    _strcat(tmp, pid);
+    fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1)
+        return (free(tmp), -1);
+    h->nlines = code->nlines;
+    h->ntoks = code->ntoks;
+    ok = write(fd, h, sizeof(*h)) == (ssize_t)sizeof(*h)
+        && write(fd, path, h->path_len) == (ssize_t)h->path_len
+        && write(fd, pad, plen) == (ssize_t)plen
+        && write(fd, code->lines, sizeof(code_line_t) * code->nlines)
+            == (ssize_t)(sizeof(code_line_t) * code->nlines)
+        && write(fd, code->toks, sizeof(token_t) * code->ntoks)
+            == (ssize_t)(sizeof(token_t) * code->ntoks);
+    close(fd);
+    if (!ok || rename(tmp, file) == -1)
+    {
+        unlink(tmp);
+        ok = 0;
+    }
+    free(tmp);
+    return (ok ? 0 : -1);
+}
+
+/**
+ * code_read - maps the cache file of a script if it is up to date
+ * @code: the code to fill in
+ * @h: the header the file must start with
+ * @path: absolute path of the script
+ * @file: the cache file
+ *
+ * Return: 0 on success, -1 if the file is missing, stale or corrupt
+ */
+static int code_read(code_t *code, code_header_t *h, char *path, char *file)
+{
+    code_header_t *fh;
+    struct stat st;
+    size_t off = sizeof(*h) + code_pad(h->path_len), rest;
+    char *m;
+    int fd = open(file, O_RDONLY | O_CLOEXEC);
+
+    if (fd == -1)
+        return (-1);
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < off)
+        return (close(fd), -1);
+    m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return (-1);
+    fh = (code_header_t *)m;
+    if (memcmp(fh, h, offsetof(code_header_t, nlines))
+            || memcmp(m + sizeof(*h), path, h->path_len)
+            || fh->nlines > ((size_t)st.st_size - off) / sizeof(code_line_t))
+        return (munmap(m, st.st_size), -1);
+    /* divided rather than multiplied, so a huge count cannot wrap */
+    rest = (size_t)st.st_size - off - sizeof(code_line_t) * fh->nlines;
+    if (rest % sizeof(token_t) || fh->ntoks != rest / sizeof(token_t))
+        return (munmap(m, st.st_size), -1);
+    code->blob = m;
+    code->blob_len = st.st_size;
+    code->lines = (code_line_t *)(m + off);
+    code->nlines = fh->nlines;
+    code->toks = (token_t *)(m + off + sizeof(code_line_t) * fh->nlines);
+    code->ntoks = fh->ntoks;
+    return (0);
+}
+
+/**
+ * code_load - sets up the code of the script mapped by map_input()
+ * @info: parameter struct
+ * @path: path of the script
+ *
+ * The cached code is used when it is up to date; otherwise the script is
+ * compiled and the cache refreshed. Failing to do either only means the
+ * script is lexed line by line as it runs.
+ *
+ * Return: 0 if the script has code, -1 otherwise
+ */
+int code_load(info_t *info, char *path)
+{
+    code_header_t h;
+    struct stat st;
+    char *abs, *file = NULL;
+    int r = -1;
+
+    if (!info->map || fstat(info->readfd, &st) == -1)
+        return (-1);
+    abs = realpath(path, NULL);
+    if (abs)
+        file = code_file(info, abs, 1);
+    if (file)
+    {
+        code_header(&h, &st, abs);
+        r = code_read(&(info->code), &h, abs, file);
+        if (r == -1 && code_build(info) == 0)
+        {
+            code_write(&(info->code), &h, abs, file);
+            r = 0;
+        }
+    }
+    free(abs);
+    free(file);
+    return (r);
+}
+
+/**
+ * code_compile - compiles a script into its cache file without running it
+ * @info: parameter struct
+ * @path: path of the script
+ *
+ * Return: 0 on success, 1 with an error printed otherwise
+ */
+int code_compile(info_t *info, char *path)
+{
+    code_header_t h;
+    struct stat st;
+    char *abs = NULL, *file = NULL;
+    int fd, r = 1;
+
+    errno = 0;
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd != -1 && fstat(fd, &st) == 0)
+    {
+        info->readfd = fd;
+        map_input(info);
+        abs = realpath(path, NULL);
+        if (abs)
+            file = code_file(info, abs, 1);
+        code_header(&h, &st, abs ? abs : path);
+        if (!st.st_size)
+            r = 0;
+        else if (info->map && file && code_build(info) == 0)
+            r = code_write(&(info->code), &h, abs, file) == 0 ? 0 : 1;
+        code_free(&(info->code));
+        unmap_input(info);
+        info->readfd = 0;
+    }
+    if (r)
+    {
+        _eputs(info->fname);
+        _eputs(": cannot compile ");
+        _eputs(path);
+        if (errno)
+        {
+            _eputs(": ");
+            _eputs(strerror(errno));
+        }
+        _eputchar('\n');
+    }
+    if (fd != -1)
+        close(fd);
+    free(abs);
+    free(file);
+    return (r);
+}
+
+/**
+ * code_free - releases the code of a script
+ * @code: the code
+ */
+void code_free(code_t *code)
+{
+    if (code->blob)
+        munmap(code->blob, code->blob_len);
+    else
+    {
+        free(code->lines);
+        free(code->toks);
+    }
+    code->lines = NULL;
+    code->toks = NULL;
+    code->blob = NULL;
+    code->nlines = code->ntoks = code->next = code->blob_len = 0;
+}
+#endif
@@ -0,0 +1,923 @@
+#include "shell.h"
+
+/*
+ * Compound commands. When a command starts with a reserved word, the
+ * rest of its line and as many further lines as needed are gathered into
+ * a program, parsed once into a tree of nodes and run from the tree. The
+ * simple commands of the tree are token ranges of the program, run by
+ * run_command() like any other command, so a loop body is never lexed or
+ * parsed again.
+ */
+
+/* reserved words, as returned by keyword() */
+#define KW_IF 1
+#define KW_THEN 2
+#define KW_ELIF 3
+#define KW_ELSE 4
+#define KW_FI 5
+#define KW_WHILE 6
+#define KW_UNTIL 7
+#define KW_FOR 8
+#define KW_DO 9
+#define KW_DONE 10
+#define KW_CASE 11
+#define KW_ESAC 12
+
+/* what ends a list: reserved words by their bit, and ';;' by bit 0 */
+#define KW_BIT(kw) (1 << (kw))
+#define STOP_DSEMI 1
+
+/* outcome of parsing a program */
+#define PARSE_OK 0
+#define PARSE_MORE 1 /* the input ends inside a command */
+#define PARSE_ERROR -1
+
+/* node kinds */
+#define NODE_CMD 0
+#define NODE_IF 1
+#define NODE_WHILE 2
+#define NODE_UNTIL 3
+#define NODE_FOR 4
+#define NODE_CASE 5
+#define NODE_ITEM 6
+
+/**
+ * struct node - a command of a parsed program
+ * @kind: NODE_ kind
+ * @sep: the token kind that ends the command: TOK_SEMI, TOK_AND, TOK_OR
+ *       or TOK_BG
+ * @start: NODE_CMD: first token; NODE_FOR: first word of the list;
+ *         NODE_ITEM: first pattern
+ * @end: one past the last token of the range that starts at start
+ * @word: NODE_FOR: the variable; NODE_CASE: the word to match
+ * @a: NODE_IF, NODE_WHILE, NODE_UNTIL: the condition; NODE_CASE: items
+ * @b: the body: then part, loop body or commands of a case item
+ * @c: NODE_IF: the elif or else part, if any
+ * @next: the next command of the list
+ */
+typedef struct node
+{
+    int kind;
+    int sep;
+    size_t start;
+    size_t end;
+    size_t word;
+    struct node *a;
+    struct node *b;
+    struct node *c;
+    struct node *next;
+} node_t;
+
+/**
+ * struct program - commands gathered from one or more lines
+ * @text: the lines, joined by newlines
+ * @len: length of text
+ * @cap: bytes allocated for text
+ * @tokens: the tokens of text; each newline is a TOK_SEMI
+ * @arena: holds the nodes
+ * @root: the parsed commands
+ * @nested: on if parsing last stopped inside a compound command
+ * @interrupted: on once ctrl-C was pressed while running
+ */
+typedef struct program
+{
+    char *text;
+    size_t len;
+    size_t cap;
+    tokens_t tokens;
+    arena_t arena;
+    node_t *root;
+    int nested;
+    int interrupted;
+} program_t;
+
+/**
+ * struct parser - state of parse_program()
+ * @info: the parameter struct, for error messages
+ * @pg: the program being parsed
+ * @t: its tokens
+ * @n: number of tokens
+ * @i: the current token
+ * @depth: number of compound commands being parsed
+ * @err: PARSE_OK, or why parsing stopped
+ */
+typedef struct parser
+{
+    info_t *info;
+    program_t *pg;
+    token_t *t;
+    size_t n;
+    size_t i;
+    int depth;
+    int err;
+} parser_t;
+
+static const char *const keywords[] = {NULL, "if", "then", "elif", "else",
+    "fi", "while", "until", "for", "do", "done", "case", "esac"};
+
+static node_t *parse_list(parser_t *p, int stop);
+
+/**
+ * keyword - tells whether a token is a reserved word
+ * @base: the line the token refers to
+ * @t: the token
+ *
+ * Only unquoted words are reserved; "if" and \if are plain words.
+ *
+ * Return: the KW_ value of the word, or 0 if it is not reserved
+ */
+int keyword(char *base, token_t *t)
+{
+    int k;
+
+    if (t->kind != TOK_WORD || t->flags || t->len < 2 || t->len > 5)
+        return (0);
+    for (k = KW_IF; k <= KW_ESAC; k++)
+        if ((size_t)_strlen((char *)keywords[k]) == t->len
+                && !memcmp(base + t->off, keywords[k], t->len))
+            return (k);
+    return (0);
+}
+
+/**
+ * is_word - tells whether the current token is a given unquoted word
+ * @p: the parser
+ * @word: the word
+ *
+ * Return: 1 if it is, 0 otherwise
+ */
+static int is_word(parser_t *p, const char *word)
+{
+    token_t *t = &p->t[p->i];
+
+    return (p->i < p->n && t->kind == TOK_WORD && !t->flags
+            && t->len == (size_t)_strlen((char *)word)
+            && !memcmp(p->pg->text + t->off, word, t->len));
+}
+
+/**
+ * at_kw - tells whether the current token is a given reserved word
+ * @p: the parser
+ * @kw: the KW_ value
+ *
+ * Return: 1 if it is, 0 otherwise
+ */
+static int at_kw(parser_t *p, int kw)
+{
+    return (p->i < p->n && keyword(p->pg->text, &p->t[p->i]) == kw);
+}
+
+/**
+ * unexpected - stops parsing at the current token
+ * @p: the parser
+ *
+ * Running out of tokens only means more lines are needed; any other
+ * token is reported as a syntax error.
+ *
+ * Return: always NULL
+ */
+static node_t *unexpected(parser_t *p)
+{
+    static char msg[48];
+    token_t *t = &p->t[p->i];
+    size_t len;
+
+    if (p->i >= p->n)
+    {
+        p->err = PARSE_MORE;
+        return (NULL);
+    }
+    p->err = PARSE_ERROR;
+    if (t->kind != TOK_WORD)
+    {
+        syntax_error(p->info, tok_unexpected(t));
+        return (NULL);
+    }
+    len = t->len < 32 ? t->len : 32;
+    msg[0] = '"';
+    memcpy(msg + 1, p->pg->text + t->off, len);
+    _strcpy(msg + 1 + len, "\" unexpected");
+    syntax_error(p->info, msg);
+    return (NULL);
+}
+
+/**
+ * expect - consumes a reserved word that must come next
+ * @p: the parser
+ * @kw: the KW_ value
+ *
+ * Return: 1 if it was there, 0 otherwise
+ */
+static int expect(parser_t *p, int kw)
+{
+    if (!at_kw(p, kw))
+        return (unexpected(p), 0);
+    p->i++;
+    return (1);
+}
+
+/**
+ * skip_newlines - skips the separators between commands
+ * @p: the parser
+ */
+static void skip_newlines(parser_t *p)
+{
+    while (p->i < p->n && p->t[p->i].kind == TOK_SEMI)
+        p->i++;
+}
+
+/**
+ * new_node - allocates a node from the program arena
+ * @p: the parser
+ * @kind: NODE_ kind
+ *
+ * Return: the node, or NULL with an error reported
+ */
+static node_t *new_node(parser_t *p, int kind)
+{
+    node_t *n = arena_alloc(&(p->pg->arena), sizeof(node_t));
+
+    if (!n)
+    {
+        p->err = PARSE_ERROR;
+        syntax_error(p->info, "out of memory");
+        return (NULL);
+    }
+    _memset((char *)n, 0, sizeof(*n));
+    n->kind = kind;
+    n->sep = TOK_SEMI;
+    return (n);
+}
+
+/**
+ * parse_body - parses a list that must have at least one command
+ * @p: the parser
+ * @stop: KW_BIT()s of the reserved words that end the list
+ *
+ * Return: the list, or NULL
+ */
+static node_t *parse_body(parser_t *p, int stop)
+{
+    node_t *list = parse_list(p, stop);
+
+    if (!list && !p->err)
+        unexpected(p);
+    return (p->err ? NULL : list);
+}
+
+/**
+ * parse_if - parses if/elif ... then ... [elif ...] [else ...] fi
+ * @p: the parser, at the if or elif
+ *
+ * An elif is parsed as an if nested in the else part; both share the fi.
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_if(parser_t *p)
+{
+    node_t *n = new_node(p, NODE_IF);
+
+    if (!n)
+        return (NULL);
+    p->i++;
+    n->a = parse_body(p, KW_BIT(KW_THEN));
+    if (!n->a || !expect(p, KW_THEN))
+        return (NULL);
+    n->b = parse_body(p, KW_BIT(KW_ELIF) | KW_BIT(KW_ELSE) | KW_BIT(KW_FI));
+    if (!n->b)
+        return (NULL);
+    if (at_kw(p, KW_ELIF))
+    {
+        n->c = parse_if(p);
+        return (n->c ? n : NULL);
+    }
+    if (at_kw(p, KW_ELSE))
+    {
+        p->i++;
+        n->c = parse_body(p, KW_BIT(KW_FI));
+        if (!n->c)
+            return (NULL);
+    }
+    return (expect(p, KW_FI) ? n : NULL);
+}
+
+/**
+ * parse_loop - parses while/until ... do ... done
+ * @p: the parser, at the while or until
+ * @kw: KW_WHILE or KW_UNTIL
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_loop(parser_t *p, int kw)
+{
+    node_t *n = new_node(p, kw == KW_WHILE ? NODE_WHILE : NODE_UNTIL);
+
+    if (!n)
+        return (NULL);
+    p->i++;
+    n->a = parse_body(p, KW_BIT(KW_DO));
+    if (!n->a || !expect(p, KW_DO))
+        return (NULL);
+    n->b = parse_body(p, KW_BIT(KW_DONE));
+    return (n->b && expect(p, KW_DONE) ? n : NULL);
+}
+
+/**
+ * parse_for - parses for NAME [in WORD...] do ... done
+ * @p: the parser, at the for
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_for(parser_t *p)
+{
+    node_t *n = new_node(p, NODE_FOR);
+    token_t *t;
+    char *w;
+    size_t k;
+
+    if (!n)
+        return (NULL);
+    t = &p->t[++p->i];
+    if (p->i >= p->n || t->kind != TOK_WORD || t->flags)
+        return (unexpected(p));
+    w = p->pg->text + t->off;
+    for (k = 0; k < t->len; k++)
+        if (!_isalpha(w[k]) && w[k] != '_' && (!k || w[k] < '0' || w[k] > '9'))
+            return (unexpected(p));
+    n->word = p->i++;
+    skip_newlines(p);
+    n->start = n->end = p->i;
+    if (is_word(p, "in"))
+    {
+        for (n->start = ++p->i; p->i < p->n && p->t[p->i].kind == TOK_WORD;)
+            p->i++;
+        n->end = p->i;
+        if (p->i >= p->n || p->t[p->i].kind != TOK_SEMI)
+            return (unexpected(p));
+        skip_newlines(p);
+    }
+    if (!expect(p, KW_DO))
+        return (NULL);
+    n->b = parse_body(p, KW_BIT(KW_DONE));
+    return (n->b && expect(p, KW_DONE) ? n : NULL);
+}
+
+/**
+ * parse_item - parses one [(]PATTERN[|PATTERN...]) COMMANDS;; of a case
+ * @p: the parser, at the item
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_item(parser_t *p)
+{
+    node_t *n = new_node(p, NODE_ITEM);
+
+    if (!n)
+        return (NULL);
+    if (p->t[p->i].kind == TOK_LPAREN)
+        p->i++;
+    n->start = p->i;
+    while (1)
+    {
+        if (p->i >= p->n || p->t[p->i].kind != TOK_WORD)
+            return (unexpected(p));
+        if (++p->i >= p->n || p->t[p->i].kind != TOK_PIPE)
+            break;
+        p->i++;
+    }
+    n->end = p->i;
+    if (p->i >= p->n || p->t[p->i].kind != TOK_RPAREN)
+        return (unexpected(p));
+    p->i++;
+    n->b = parse_list(p, KW_BIT(KW_ESAC) | STOP_DSEMI);
+    if (p->err)
+        return (NULL);
+    if (p->i < p->n && p->t[p->i].kind == TOK_DSEMI)
+        p->i++;
+    else if (!at_kw(p, KW_ESAC))
+        return (unexpected(p));
+    return (n);
+}
+
+/**
+ * parse_case - parses case WORD in ITEM... esac
+ * @p: the parser, at the case
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_case(parser_t *p)
+{
+    node_t *n = new_node(p, NODE_CASE), **tail;
+
+    if (!n)
+        return (NULL);
+    if (++p->i >= p->n || p->t[p->i].kind != TOK_WORD)
+        return (unexpected(p));
+    n->word = p->i++;
+    skip_newlines(p);
+    if (!is_word(p, "in"))
+        return (unexpected(p));
+    p->i++;
+    for (tail = &n->a; 1; tail = &(*tail)->next)
+    {
+        skip_newlines(p);
+        if (at_kw(p, KW_ESAC))
+            break;
+        if (p->i >= p->n)
+            return (unexpected(p));
+        *tail = parse_item(p);
+        if (!*tail)
+            return (NULL);
+    }
+    p->i++;
+    return (n);
+}
+
+/**
+ * parse_command - parses a simple command, pipeline or compound command
+ * @p: the parser, at the command
+ *
+ * Return: the node, or NULL
+ */
+static node_t *parse_command(parser_t *p)
+{
+    int kw = keyword(p->pg->text, &p->t[p->i]), kind;
+    node_t *n;
+
+    if (!kw)
+    {
+        n = new_node(p, NODE_CMD);
+        if (!n)
+            return (NULL);
+        for (n->start = p->i; p->i < p->n; p->i++)
+        {
+            kind = p->t[p->i].kind;
+            if (kind == TOK_SEMI || kind == TOK_AND || kind == TOK_OR
+                    || kind == TOK_BG || kind == TOK_DSEMI)
+                break;
+        }
+        n->end = p->i;
+        return (n->end > n->start ? n : unexpected(p));
+    }
+    p->depth++;
+    if (kw == KW_IF)
+        n = parse_if(p);
+    else if (kw == KW_WHILE || kw == KW_UNTIL)
+        n = parse_loop(p, kw);
+    else if (kw == KW_FOR)
+        n = parse_for(p);
+    else if (kw == KW_CASE)
+        n = parse_case(p);
+    else
+        return (unexpected(p));
+    if (!n)
+        return (NULL);
+    p->depth--;
+    kind = p->i < p->n ? p->t[p->i].kind : TOK_SEMI;
+    if (kind != TOK_SEMI && kind != TOK_AND && kind != TOK_OR
+            && kind != TOK_DSEMI)
+        return (unexpected(p)); /* no pipes, redirections or & yet */
+    return (n);
+}
+
+/**
+ * parse_list - parses commands separated by ; & && || and newlines
+ * @p: the parser
+ * @stop: KW_BIT()s of the reserved words that end the list, and
+ *        STOP_DSEMI if ';;' does; 0 for a list that ends with the input
+ *
+ * Return: the first command of the list, NULL if it is empty or on error
+ */
+static node_t *parse_list(parser_t *p, int stop)
+{
+    node_t *head = NULL, **tail = &head, *n;
+    int kw, kind, need = 0;
+
+    while (!p->err)
+    {
+        skip_newlines(p);
+        if (p->i >= p->n)
+        {
+            if (stop || need)
+                p->err = PARSE_MORE;
+            break;
+        }
+        kw = keyword(p->pg->text, &p->t[p->i]);
+        if (!need && ((kw && stop & KW_BIT(kw))
+                    || (p->t[p->i].kind == TOK_DSEMI && stop & STOP_DSEMI)))
+            break;
+        n = parse_command(p);
+        if (!n)
+            break;
+        *tail = n;
+        tail = &n->next;
+        need = 0;
+        kind = p->i < p->n ? p->t[p->i].kind : TOK_SEMI;
+        if (kind == TOK_SEMI || kind == TOK_AND || kind == TOK_OR
+                || kind == TOK_BG)
+        {
+            n->sep = kind;
+            need = kind == TOK_AND || kind == TOK_OR;
+            if (p->i < p->n)
+                p->i++;
+        }
+    }
+    return (p->err ? NULL : head);
+}
+
+/**
+ * parse_program - parses the commands gathered so far
+ * @info: the parameter struct
+ * @pg: the program
+ *
+ * Return: PARSE_OK, PARSE_MORE, or PARSE_ERROR with the error reported
+ */
+static int parse_program(info_t *info, program_t *pg)
+{
+    parser_t p;
+
+    p.info = info;
+    p.pg = pg;
+    p.t = pg->tokens.v;
+    p.n = pg->tokens.n;
+    p.i = 0;
+    p.depth = 0;
+    p.err = PARSE_OK;
+    arena_reset(&(pg->arena));
+    pg->root = parse_list(&p, 0);
+    pg->nested = p.depth > 0;
+    return (p.err);
+}
+
+/**
+ * prog_append - adds the rest of the current line to a program
+ * @pg: the program
+ * @info: the parameter struct, holding the line and its tokens
+ * @first: index of the first token to add
+ *
+ * Return: 1 if the line has a fi, done or esac, 0 if not, -1 on
+ * allocation failure
+ */
+static int prog_append(program_t *pg, info_t *info, size_t first)
+{
+    token_t *t = info->tokens.v, *v;
+    size_t n = info->tokens.n, base = 0, len = 0, cap, k;
+    char *text;
+    int kw, closer = 0;
+
+    if (first < n)
+    {
+        base = t[first].off;
+        len = t[n - 1].off + t[n - 1].len - base;
+    }
+    if (pg->len + len + 2 > pg->cap)
+    {
+        for (cap = pg->cap ? pg->cap : 256; cap < pg->len + len + 2;)
+            cap *= 2;
+        text = realloc(pg->text, cap);
+        if (!text)
+            return (-1);
+        pg->text = text;
+        pg->cap = cap;
+    }
+    if (pg->tokens.n + n - first + 1 > pg->tokens.cap)
+    {
+        for (cap = pg->tokens.cap ? pg->tokens.cap : 64;
+                cap < pg->tokens.n + n - first + 1;)
+            cap *= 2;
+        v = realloc(pg->tokens.v, sizeof(token_t) * cap);
+        if (!v)
+            return (-1);
+        pg->tokens.v = v;
+        pg->tokens.cap = cap;
+    }
+    if (pg->len)
+    {
+        v = &pg->tokens.v[pg->tokens.n++];
+        v->off = pg->len;
+        v->len = 1;
+        v->kind = TOK_SEMI;
+        v->flags = 0;
+        pg->text[pg->len++] = '\n';
+    }
+    memcpy(pg->text + pg->len, info->tok_base + base, len);
+    for (k = first; k < n; k++)
+    {
+        v = &pg->tokens.v[pg->tokens.n++];
+        *v = t[k];
+        v->off = t[k].off - base + pg->len;
+        kw = keyword(info->tok_base, &t[k]);
+        closer |= kw == KW_FI || kw == KW_DONE || kw == KW_ESAC;
+    }
+    pg->len += len;
+    pg->text[pg->len] = 0;
+    return (closer);
+}
+
+/**
+ * match - matches a string against a glob pattern
+ * @p: the pattern, with *, ? and [...]
+ * @s: the string
+ *
+ * Return: 1 if it matches, 0 otherwise
+ */
+static int match(const char *p, const char *s)
+{
+    const char *q;
+    int neg, hit, k;
+
+    for (; *p; p++, s++)
+    {
+        if (*p == '*')
+        {
+            while (*p == '*')
+                p++;
+            for (; *s; s++)
+                if (match(p, s))
+                    return (1);
+            return (!*p);
+        }
+        if (!*s)
+            return (0);
+        if (*p == '?')
+        {
+            for (k = get_utf8_char_length(*s); k > 1 && s[1]; k--)
+                s++;
+            continue;
+        }
+        if (*p == '[')
+        {
+            q = p + 1;
+            neg = *q == '!' || *q == '^';
+            q += neg;
+            hit = 0;
+            for (k = 1; *q && (*q != ']' || k); q++, k = 0)
+                if (q[1] == '-' && q[2] && q[2] != ']')
+                {
+                    hit |= (unsigned char)*s >= (unsigned char)*q
+                        && (unsigned char)*s <= (unsigned char)q[2];
+                    q += 2;
+                }
+                else
+                    hit |= *s == *q;
+            if (*q)
+            {
+                if (hit == neg)
+                    return (0);
+                p = q;
+                continue;
+            }
+        }
+        if (*p != *s)
+            return (0);
+    }
+    return (!*s);
+}
+
+static int run_list(info_t *info, program_t *pg, node_t *n, int prev);
+
+/**
+ * interrupted - tells whether ctrl-C stopped the program
+ * @pg: the program
+ *
+ * Return: 1 once SIGINT was received, 0 before
+ */
+static int interrupted(program_t *pg)
+{
+    if (!pg->interrupted && sigint_pending())
+    {
+        pg->interrupted = 1;
+        return (1);
+    }
+    return (pg->interrupted);
+}
+
+/**
+ * run_simple - runs a simple command or pipeline of the program
+ * @info: the parameter struct
+ * @pg: the program
+ * @n: the node
+ *
+ * Return: what run_command() returned
+ */
+static int run_simple(info_t *info, program_t *pg, node_t *n)
+{
+    token_t *t = pg->tokens.v;
+    int r;
+
+    clear_info(info);
+    info->tok_start = n->start;
+    info->tok_end = n->end;
+    info->background = n->sep == TOK_BG;
+    info->arg = pg->text + t[n->start].off;
+    pg->text[t[n->end - 1].off + t[n->end - 1].len] = 0;
+    r = run_command(info);
+    free_info(info, 0);
+    return (r);
+}
+
+/**
+ * run_for - runs a for loop
+ * @info: the parameter struct
+ * @pg: the program
+ * @n: the node
+ *
+ * The words are expanded once, before the first iteration, and the
+ * variable is set in the environment, where $NAME finds it.
+ *
+ * Return: -2 if the shell must exit, 0 otherwise
+ */
+static int run_for(info_t *info, program_t *pg, node_t *n)
+{
+    token_t *t = pg->tokens.v;
+    size_t k, count = n->end - n->start;
+    char **words = malloc(sizeof(char *) * (count + 1)), *name, *w;
+    int r = 0, st = 0;
+
+    name = tok_word(info, pg->text, &t[n->word]);
+    for (k = 0; words && k < count; k++)
+    {
+        w = tok_word(info, pg->text, &t[n->start + k]);
+        words[k] = w ? shell_strdup(w) : NULL;
+        if (!words[k])
+            break;
+    }
+    free_info(info, 0);
+    if (!words || k < count)
+    {
+        st = 1;
+        count = words ? k : 0;
+    }
+    else
+        for (k = 0; k < count && r != -2 && !interrupted(pg); k++)
+        {
+            _setenv(info, name, words[k]);
+            r = run_list(info, pg, n->b, TOK_SEMI);
+            st = info->status;
+        }
+    for (k = 0; k < count; k++)
+        free(words[k]);
+    free(words);
+    info->status = st;
+    return (r == -2 ? -2 : 0);
+}
+
+/**
+ * run_case - runs the commands of the first item whose pattern matches
+ * @info: the parameter struct
+ * @pg: the program
+ * @n: the node
+ *
+ * Quoted patterns match literally, others as globs.
+ *
+ * Return: -2 if the shell must exit, 0 otherwise
+ */
+static int run_case(info_t *info, program_t *pg, node_t *n)
+{
+    token_t *t = pg->tokens.v;
+    char *word = tok_word(info, pg->text, &t[n->word]), *pat;
+    node_t *item;
+    size_t k;
+    int quoted;
+
+    for (item = n->a; word && item; item = item->next)
+        for (k = item->start; k < item->end; k += 2)
+        {
+            quoted = t[k].flags & TOKF_QUOTED;
+            pat = tok_word(info, pg->text, &t[k]);
+            if (pat && (quoted ? !_strcmp(pat, word) : match(pat, word)))
+            {
+                free_info(info, 0);
+                info->status = 0;
+                return (run_list(info, pg, item->b, TOK_SEMI));
+            }
+        }
+    free_info(info, 0);
+    info->status = 0;
+    return (0);
+}
+
+/**
+ * run_node - runs a command of the program
+ * @info: the parameter struct
+ * @pg: the program
+ * @n: the node
+ *
+ * Return: -2 if the shell must exit, 0 otherwise
+ */
+static int run_node(info_t *info, program_t *pg, node_t *n)
+{
+    int st = 0;
+
+    if (n->kind == NODE_CMD)
+        return (run_simple(info, pg, n));
+    if (n->kind == NODE_FOR)
+        return (run_for(info, pg, n));
+    if (n->kind == NODE_CASE)
+        return (run_case(info, pg, n));
+    if (n->kind == NODE_IF)
+    {
+        if (run_list(info, pg, n->a, TOK_SEMI) == -2)
+            return (-2);
+        if (!info->status)
+            return (run_list(info, pg, n->b, TOK_SEMI));
+        if (n->c)
+            return (run_list(info, pg, n->c, TOK_SEMI));
+        info->status = 0;
+        return (0);
+    }
+    while (!interrupted(pg))
+    {
+        if (run_list(info, pg, n->a, TOK_SEMI) == -2)
+            return (-2);
+        if (!info->status != (n->kind == NODE_WHILE) || pg->interrupted)
+            break;
+        if (run_list(info, pg, n->b, TOK_SEMI) == -2)
+            return (-2);
+        st = info->status;
+    }
+    info->status = pg->interrupted ? 130 : st;
+    return (0);
+}
+
+/**
+ * run_list - runs a list of commands
+ * @info: the parameter struct
+ * @pg: the program
+ * @n: the first command
+ * @prev: the token kind before the first command
+ *
+ * Return: -2 if the shell must exit, 0 otherwise
+ */
+static int run_list(info_t *info, program_t *pg, node_t *n, int prev)
+{
+    for (; n && !interrupted(pg); prev = n->sep, n = n->next)
+    {
+        if ((prev == TOK_AND && info->status)
+                || (prev == TOK_OR && !info->status))
+            continue;
+        if (run_node(info, pg, n) == -2)
+            return (-2);
+    }
+    return (0);
+}
+
+/**
+ * run_compound - runs the commands from a reserved word on
+ * @info: the parameter struct, with tok_start at the reserved word
+ *
+ * Lines are read until every compound command is closed, then the whole
+ * program is parsed and run. A line is only parsed again if it can close
+ * a compound command, so gathering a long loop costs linear time.
+ *
+ * Return: -2 if the shell must exit, 0 otherwise
+ */
+int run_compound(info_t *info)
+{
+    program_t pg;
+    tokens_t line;
+    char *base;
+    int r, closer, prev, ret = 0;
+
+    _memset((char *)&pg, 0, sizeof(pg));
+    prev = info->cmd_buf_type == CMD_AND ? TOK_AND
+        : info->cmd_buf_type == CMD_OR ? TOK_OR : TOK_SEMI;
+    info->cmd_buf_type = CMD_NORM;
+    closer = prog_append(&pg, info, info->tok_start);
+    r = closer == -1 ? PARSE_ERROR : parse_program(info, &pg);
+    while (r == PARSE_MORE)
+    {
+        r = get_more(info);
+        if (r < 0)
+        {
+            if (r == -1)
+                syntax_error(info, "end of file unexpected");
+            r = PARSE_ERROR;
+            break;
+        }
+        closer = prog_append(&pg, info, 0);
+        if (closer == -1)
+            r = PARSE_ERROR;
+        else if (closer || !pg.nested)
+            r = parse_program(info, &pg);
+        else
+            r = PARSE_MORE;
+    }
+    if (closer == -1)
+        syntax_error(info, "out of memory");
+    if (r == PARSE_OK)
+    {
+        line = info->tokens;
+        base = info->tok_base;
+        info->tokens = pg.tokens;
+        info->tok_base = pg.text;
+        sigint_pending();
+        ret = run_list(info, &pg, pg.root, prev);
+        info->tokens = line;
+        info->tok_base = base;
+    }
+    free(pg.text);
+    free(pg.tokens.v);
+    arena_free(&(pg.arena));
+    return (ret);
+}
@@ -8,30 +8,28 @@
  */
 int _myenv(info_t *info)
 {
-    print_list_str(info->env);
+    varmap_print(&(info->env));
     return (0);
 }
 
 /**
  * _getenv - gets the value of an environ variable
  * @info: Structure containing potential arguments. Used to maintain
- * @name: env var name
+ * @name: env var name, optionally followed by '='
  *
- * Return: the value
+ * Return: the value, or NULL if the variable is unset or empty
  */
 char *_getenv(info_t *info, const char *name)
 {
-    list_t *node = info->env;
-    char *p;
+    size_t len = _strlen((char *)name);
+    var_entry_t *e;
 
-    while (node)
-    {
-        p = starts_with(node->str, name);
-        if (p && *p)
-            return (p);
-        node = node->next;
-    }
-    return (NULL);
+    if (len && name[len - 1] == '=')
+        len--;
+    e = varmap_find(&(info->env), name, len);
+    if (!e || !e->str[len] || !e->str[len + 1])
+        return (NULL);
+    return (e->str + len + 1);
 }
 
 /**
@@ -75,19 +73,17 @@ int _myunsetenv(info_t *info)
 }
 
 /**
- * populate_env_list - populates env linked list
+ * populate_env_list - populates the env hash map
  * @info: Structure containing potential arguments. Used to maintain
  *          constant function prototype.
+ *
+ * The inherited strings are referenced in place; a variable is only
+ * copied into shell memory when it is set again.
+ *
  * Return: Always 0
  */
 int populate_env_list(info_t *info)
 {
-    list_t *node = NULL;
-    size_t i;
-    char **env = shell_environ;
-
-    for (i = 0; env && env[i]; i++)
-        add_node_end(&node, env[i], 0);
-    info->env = node;
+    varmap_import(&(info->env), shell_environ);
     return (0);
 }
@@ -8,15 +8,21 @@
  */
 void _eputs(char *str)
 {
-	int i = 0;
-
 	if (!str)
 		return;
-	while (str[i] != '\0')
-	{
-		_eputchar(str[i]);
-		i++;
-	}
+	_eputsn(str, _strlen(str));
+}
+
+/**
+ * _eputsn - prints n bytes to stderr
+ * @str: the bytes to be printed
+ * @n: number of bytes
+ *
+ * Return: n
+ */
+size_t _eputsn(const char *str, size_t n)
+{
+	return (stream_write(STDERR_FILENO, str, n));
 }
 
 /**
@@ -28,16 +34,10 @@ void _eputs(char *str)
  */
 int _eputchar(char c)
 {
-	static int i;
-	static char buf[WRITE_BUF_SIZE];
-
-	if (c == BUF_FLUSH || i >= WRITE_BUF_SIZE)
-	{
-		write(2, buf, i);
-		i = 0;
-	}
-	if (c != BUF_FLUSH)
-		buf[i++] = c;
+	if (c == BUF_FLUSH)
+		stream_flush(STDERR_FILENO);
+	else
+		stream_write(STDERR_FILENO, &c, 1);
 	return (1);
 }
 
@@ -51,19 +51,26 @@ int _eputchar(char c)
  */
 int _putfd(char c, int fd)
 {
-	static int i;
-	static char buf[WRITE_BUF_SIZE];
-
-	if (c == BUF_FLUSH || i >= WRITE_BUF_SIZE)
-	{
-		write(fd, buf, i);
-		i = 0;
-	}
-	if (c != BUF_FLUSH)
-		buf[i++] = c;
+	if (c == BUF_FLUSH)
+		stream_flush(fd);
+	else
+		stream_write(fd, &c, 1);
 	return (1);
 }
 
+/**
+ * _putfdn - writes n bytes to given fd
+ * @str: the bytes to print
+ * @n: number of bytes
+ * @fd: The filedescriptor to write to
+ *
+ * Return: n
+ */
+size_t _putfdn(const char *str, size_t n, int fd)
+{
+	return (stream_write(fd, str, n));
+}
+
 /**
  *_putsfd - prints an input string
  * @str: the string to be printed
@@ -73,13 +80,7 @@ int _putfd(char c, int fd)
  */
 int _putsfd(char *str, int fd)
 {
-	int i = 0;
-
 	if (!str)
 		return (0);
-	while (*str)
-	{
-		i += _putfd(*str++, fd);
-	}
-	return (i);
+	return (_putfdn(str, _strlen(str), fd));
 }
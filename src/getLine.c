@@ -5,8 +5,15 @@
 #define SIGINT 2
 #endif
 
+/* the current line, its length while commands remain and the next token */
+static char *line;
+static size_t line_len, line_next;
+static int lex_failed; /* on if the current line did not lex */
+static volatile sig_atomic_t got_sigint;
+static int sigint_set; /* on once sigintHandler is installed */
+
 /**
- * input_buf - buffers chained commands
+ * input_buf - reads the next line and splits it into tokens
  * @info: parameter struct
  * @buf: address of buffer
  * @len: address of len var
@@ -15,15 +22,14 @@
  */
 ssize_t input_buf(info_t *info, char **buf, size_t *len)
 {
+    static size_t len_p; /* capacity of *buf, which is reused */
     ssize_t r = 0;
-    size_t len_p = 0;
+    int lex_r;
 
     if (!*len) /* if nothing left in the buffer, fill it */
     {
-        /*bfree((void **)info->cmd_buf);*/
-        free(*buf);
-        *buf = NULL;
-        signal(SIGINT, sigintHandler);
+        if (!sigint_set)
+            signal(SIGINT, sigintHandler), sigint_set = 1;
 #if USE_GETLINE
         r = getline(buf, &len_p, stdin);
 #else
@@ -37,12 +43,21 @@ ssize_t input_buf(info_t *info, char **buf, size_t *len)
                 r--;
             }
             info->linecount_flag = 1;
-            remove_comments(*buf);
-            build_history_list(info, *buf, info->histcount++);
-            /* if (_strchr(*buf, ';')) is this a command chain? */
+            build_history_list(info, *buf);
+            *len = r;
+            info->cmd_buf = buf;
+        }
+        if (r >= 0 && *buf)
+        {
+            info->tok_base = *buf;
+            lex_r = info->code.lines ? code_tokens(info, r)
+                : lex(*buf, &(info->tokens));
+            lex_failed = lex_r < 0;
+            if (lex_r < 0)
             {
-                *len = r;
-                info->cmd_buf = buf;
+                syntax_error(info, lex_r == -1
+                        ? "Unterminated quoted string" : "out of memory");
+                info->tokens.n = 0;
             }
         }
     }
@@ -50,139 +65,272 @@ ssize_t input_buf(info_t *info, char **buf, size_t *len)
 }
 
 /**
- * get_input - gets a line minus the newline
+ * get_input - gets the next command of the current line
  * @info: parameter struct
  *
- * Return: bytes read
+ * Sets tok_start and tok_end to the tokens of the command, and arg to
+ * its text. A command after && or || that must not run is skipped. At
+ * a reserved word the rest of the line is left to run_compound().
+ *
+ * Return: length of the command text, INPUT_COMPOUND, or -1 at end of input
  */
 ssize_t get_input(info_t *info)
 {
-    static char *buf; /* the ';' command chain buffer */
-    static size_t i, j, len;
+    char *buf;
+    token_t *t;
+    size_t start, end, n, linelen;
     ssize_t r = 0;
-    char **buf_p = &(info->arg), *p;
+    int skip;
 
-    _putchar(BUF_FLUSH);
-    r = input_buf(info, &buf, &len);
-    if (r == -1) /* EOF */
-        return (-1);
-    if (len)    /* we have commands left in the chain buffer */
+    if (!line_len)
     {
-        j = i; /* init new iterator to current buf position */
-        p = buf + i; /* get pointer for return */
-
-        check_chain(info, buf, &j, i, len);
-        while (j < len) /* iterate to semicolon or end */
+        hist_end(info, 1);
+        r = input_buf(info, &line, &line_len);
+        if (r == -1) /* EOF */
+            return (-1);
+        line_next = 0;
+        info->cmd_buf_type = CMD_NORM;
+    }
+    buf = line;
+    t = info->tokens.v;
+    n = info->tokens.n;
+    do {
+        start = line_next;
+        if (start < n && keyword(buf, &t[start]))
         {
-            if (is_chain(info, buf, &j))
-                break;
-            j++;
+            info->tok_start = start;
+            info->tok_end = n;
+            line_len = 0;
+            return (INPUT_COMPOUND);
         }
+        for (end = start; end < n && t[end].kind != TOK_SEMI
+                && t[end].kind != TOK_AND && t[end].kind != TOK_OR
+                && t[end].kind != TOK_BG; end++)
+            ;
+        skip = (info->cmd_buf_type == CMD_AND && info->status)
+            || (info->cmd_buf_type == CMD_OR && !info->status);
+        info->cmd_buf_type = end == n ? CMD_NORM : t[end].kind == TOK_AND
+            ? CMD_AND : t[end].kind == TOK_OR ? CMD_OR : CMD_CHAIN;
+        line_next = end + 1;
+    } while (skip && end < n);
+    if (skip)
+        start = end;
+    info->background = end < n && t[end].kind == TOK_BG;
+    linelen = line_len;
+    if (line_next >= n)
+        line_len = 0;
+    info->tok_start = start;
+    info->tok_end = end;
+    if (start == end)
+    {
+        info->arg = buf + linelen;
+        return (0);
+    }
+    info->arg = buf + t[start].off;
+    buf[t[end - 1].off + t[end - 1].len] = 0;
+    return (t[end - 1].off + t[end - 1].len - t[start].off);
+}
 
-        i = j + 1; /* increment past nulled ';'' */
-        if (i >= len) /* reached end of buffer? */
-        {
-            i = len = 0; /* reset position and length */
-            info->cmd_buf_type = CMD_NORM;
-        }
+/**
+ * get_more - reads the next line of a command that spans several lines
+ * @info: parameter struct
+ *
+ * The line and its tokens are left in info->tok_base and info->tokens,
+ * and the caller takes all of it. A terminal is prompted with "> ".
+ *
+ * Return: length of the line, -1 at end of input, -2 if it does not lex
+ */
+ssize_t get_more(info_t *info)
+{
+    ssize_t r;
 
-        *buf_p = p; /* pass back pointer to current command position */
-        return (_strlen(p)); /* return length of current command */
+    if (interactive(info))
+    {
+        _puts("> ");
+        _putchar(BUF_FLUSH);
     }
-
-    *buf_p = buf; /* else not a chain, pass back buffer from _getline() */
-    return (r); /* return length of buffer from _getline() */
+    if (info->linecount_flag == 1)
+    {
+        info->line_count++;
+        info->linecount_flag = 0;
+    }
+    r = input_buf(info, &line, &line_len);
+    line_len = 0;
+    return (r != -1 && lex_failed ? -2 : r);
 }
 
 /**
  * read_buf - reads a buffer
  * @info: parameter struct
  * @buf: buffer
- * @i: size
+ * @size: number of bytes to read at most
  *
- * Return: r
+ * Return: number of bytes read, 0 at end of input, -1 on error
  */
-ssize_t read_buf(info_t *info, char *buf, size_t *i)
+ssize_t read_buf(info_t *info, char *buf, size_t size)
 {
-    ssize_t r = 0;
+    ssize_t r;
 
-    if (*i)
-        return (0);
-    r = read(info->readfd, buf, READ_BUF_SIZE);
-    if (r >= 0)
-        *i = r;
+    do {
+        r = read(info->readfd, buf, size);
+    } while (r == -1 && errno == EINTR);
     return (r);
 }
 
 /**
- * _getline - gets the next line of input from STDIN
+ * map_input - maps the script being read into memory
+ * @info: parameter struct
+ *
+ * Only regular files are mapped; pipes and terminals keep being read
+ * through read_buf(). The mapping is read-only and advised sequential,
+ * so the kernel reads ahead and drops pages behind the reader.
+ */
+void map_input(info_t *info)
+{
+#ifndef WINDOWS
+    struct stat st;
+    void *m;
+
+    if (fstat(info->readfd, &st) == -1 || !S_ISREG(st.st_mode)
+            || st.st_size <= 0)
+        return;
+    m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, info->readfd, 0);
+    if (m == MAP_FAILED)
+        return;
+    madvise(m, st.st_size, MADV_SEQUENTIAL);
+    info->map = m;
+    info->map_len = st.st_size;
+    info->map_pos = 0;
+#else
+    (void)info;
+#endif
+}
+
+/**
+ * unmap_input - releases the mapping made by map_input()
+ * @info: parameter struct
+ *
+ * A -c string read in place of a mapping is only forgotten.
+ */
+void unmap_input(info_t *info)
+{
+#ifndef WINDOWS
+    if (info->map && !info->map_borrowed)
+        munmap(info->map, info->map_len);
+#endif
+    info->map = NULL;
+    info->map_len = info->map_pos = 0;
+}
+
+/**
+ * map_getline - gets the next line of a mapped script
  * @info: parameter struct
  * @ptr: address of pointer to buffer, preallocated or NULL
- * @length: size of preallocated ptr buffer if not NULL
+ * @length: capacity of the ptr buffer, updated when it grows
+ *
+ * The line is found in the mapping without any system call. It is then
+ * copied once into *ptr, since the lexer terminates and unquotes words in
+ * place and the mapping is read-only.
  *
- * Return: s
+ * Return: length of the line including its newline, or -1 at end of input
  */
-int _getline(info_t *info, char **ptr, size_t *length)
+static ssize_t map_getline(info_t *info, char **ptr, size_t *length)
 {
-    static char buf[READ_BUF_SIZE];
-    static size_t i, len;
-    size_t k;
-    ssize_t r = 0, s = 0;
-    char *p = NULL, *new_p = NULL, *c;
-
-    p = *ptr;
-    if (p && length)
-        s = *length;
-    if (i == len)
-        i = len = 0;
-
-    r = read_buf(info, buf, &len);
-    if (r == -1 || (r == 0 && len == 0))
+    char *start = info->map + info->map_pos, *nl, *p = *ptr;
+    size_t left = info->map_len - info->map_pos, k;
+    size_t cap = p && length ? *length : 0;
+
+    if (!left)
         return (-1);
+    nl = memchr(start, '\n', left);
+    k = nl ? (size_t)(nl - start) + 1 : left;
+    if (k + 1 > cap)
+    {
+        cap = cap ? cap : 128;
+        while (cap < k + 1)
+            cap *= 2;
+        p = realloc(p, cap);
+        if (!p)
+            return (free(*ptr), *ptr = NULL, -1);
+    }
+    memcpy(p, start, k);
+    p[k] = 0;
+    info->map_pos += k;
+    *ptr = p;
+    if (length)
+        *length = cap;
+    return (k);
+}
 
-    c = _strchr(buf + i, '\n');
-    k = c ? 1 + (unsigned int)(c - buf) : len;
-    
-    /* Ensure we don't split UTF-8 characters */
-    if (k < len && (buf[k] & 0x80)) {
-        /* We might be in the middle of a UTF-8 character */
-        int char_length = 0;
-        
-        /* Check if we're in the middle of a UTF-8 sequence */
-        if ((buf[k] & 0xC0) == 0x80) {
-            /* This is a continuation byte, find the start of the character */
-            int j;
-            for (j = k - 1; j >= (int)i && (buf[j] & 0xC0) == 0x80; j--)
-                ;
-            
-            if (j >= (int)i) {
-                char_length = get_utf8_char_length(buf[j]);
-                int bytes_read = k - j;
-                
-                /* If we haven't read the complete character, adjust k */
-                if (bytes_read < char_length && k + (char_length - bytes_read) <= len) {
-                    k += (char_length - bytes_read);
-                }
+/**
+ * _getline - gets the next line of input from STDIN
+ * @info: parameter struct
+ * @ptr: address of pointer to buffer, preallocated or NULL
+ * @length: capacity of the ptr buffer, updated when it grows
+ *
+ * Both the read buffer and the line buffer grow geometrically, so a line
+ * costs time linear in its length however many reads it spans. The read
+ * size starts at READ_BUF_SIZE and doubles, up to READ_BUF_MAX, each
+ * time a read fills it and the input is not a terminal. A line is only
+ * returned once its newline (or end of input) has been read, so a
+ * multibyte character is never split between two calls. A script mapped
+ * by map_input() is sliced from memory instead.
+ *
+ * Return: length of the line including its newline, or -1 at end of input
+ */
+ssize_t _getline(info_t *info, char **ptr, size_t *length)
+{
+    static char *buf;
+    static size_t size, i, len;
+    char *p = *ptr, *nl, *grown;
+    size_t cap = p && length ? *length : 0, s = 0, k;
+    ssize_t r;
+
+    if (info->map)
+        return (map_getline(info, ptr, length));
+    while (1)
+    {
+        if (i == len)
+        {
+            if (!buf || (len == size && size < READ_BUF_MAX
+                        && !info->tty))
+            {
+                size = buf ? size * 2 : READ_BUF_SIZE;
+                free(buf);
+                buf = malloc(size);
+                if (!buf)
+                    return (size = 0, -1);
             }
+            i = len = 0;
+            r = read_buf(info, buf, size);
+            if (r <= 0)
+                break;
+            len = r;
         }
+        nl = memchr(buf + i, '\n', len - i);
+        k = nl ? (size_t)(nl - (buf + i)) + 1 : len - i;
+        if (s + k + 1 > cap)
+        {
+            cap = cap ? cap : 128;
+            while (cap < s + k + 1)
+                cap *= 2;
+            grown = realloc(p, cap);
+            if (!grown)
+                return (free(p), *ptr = NULL, -1);
+            p = grown;
+        }
+        memcpy(p + s, buf + i, k);
+        s += k;
+        i += k;
+        if (p[s - 1] == '\n')
+            break;
     }
-    
-    new_p = _realloc(p, s, s ? s + k : k + 1);
-    if (!new_p) /* MALLOC FAILURE! */
-        return (p ? free(p), -1 : -1);
-
-    if (s)
-        _strncat(new_p, buf + i, k - i);
-    else
-        _strncpy(new_p, buf + i, k - i + 1);
-
-    s += k - i;
-    i = k;
-    p = new_p;
-
-    if (length)
-        *length = s;
+    if (!s)
+        return (-1);
+    p[s] = 0;
     *ptr = p;
+    if (length)
+        *length = cap;
     return (s);
 }
 
@@ -193,6 +341,23 @@ int _getline(info_t *info, char **ptr, size_t *length)
 void sigintHandler(int sig_num)
 {
     (void)sig_num;
+#ifdef WINDOWS
+    signal(SIGINT, sigintHandler); /* the handler is reset on delivery */
+#endif
+    got_sigint = 1;
     _puts("\n$ ");
     _putchar(BUF_FLUSH);
 }
+
+/**
+ * sigint_pending - tells whether ctrl-C was pressed since the last call
+ *
+ * Return: 1 if SIGINT was received, 0 otherwise
+ */
+int sigint_pending(void)
+{
+    int r = got_sigint;
+
+    got_sigint = 0;
+    return (r);
+}
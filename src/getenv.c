@@ -1,19 +1,18 @@
 #include "shell.h"
 
 /**
- * get_environ_copy - returns the string array copy of our environ
+ * get_environ_copy - returns the environment vector passed to programs
  * @info: Structure containing potential arguments.
- * Return: String array copy of environ
+ *
+ * The vector is patched in place whenever a variable is set or unset,
+ * so handing it to exec does not allocate or copy anything.
+ *
+ * Return: NULL terminated array of NAME=value strings owned by info->env
  */
 char **get_environ_copy(info_t *info)
 {
-    if (!info->env_array || info->env_changed)
-    {
-        info->env_array = list_to_strings(info->env);
-        info->env_changed = 0;
-    }
-
-    return (info->env_array);
+    info->env_changed = 0;
+    return (varmap_vector(&(info->env)));
 }
 
 /**
@@ -24,26 +23,13 @@ char **get_environ_copy(info_t *info)
  */
 int _unsetenv(info_t *info, char *var)
 {
-    list_t *node = info->env;
-    size_t i = 0;
-    char *p;
-
-    if (!node || !var)
+    if (!var)
         return (0);
 
-    while (node)
-    {
-        p = starts_with(node->str, var);
-        if (p && *p == '=')
-        {
-            info->env_changed = delete_node_at_index(&(info->env), i);
-            i = 0;
-            node = info->env;
-            continue;
-        }
-        node = node->next;
-        i++;
-    }
+    if (varmap_unset(&(info->env), var, _strlen(var)))
+        info->env_changed = 1;
+    if (!_strcmp(var, "PATH"))
+        hash_reset(info);
     return (info->env_changed);
 }
 
@@ -58,8 +44,6 @@ int _unsetenv(info_t *info, char *var)
 int _setenv(info_t *info, char *var, char *value)
 {
     char *buf = NULL;
-    list_t *node;
-    char *p;
 
     if (!var || !value)
         return (0);
@@ -67,24 +51,16 @@ int _setenv(info_t *info, char *var, char *value)
     buf = malloc(_strlen(var) + _strlen(value) + 2);
     if (!buf)
         return (1);
+    if (!_strcmp(var, "PATH"))
+        hash_reset(info);
     _strcpy(buf, var);
     _strcat(buf, "=");
     _strcat(buf, value);
-    node = info->env;
-    while (node)
+    if (varmap_set(&(info->env), buf) == -1)
     {
-        p = starts_with(node->str, var);
-        if (p && *p == '=')
-        {
-            free(node->str);
-            node->str = buf;
-            info->env_changed = 1;
-            return (0);
-        }
-        node = node->next;
+        free(buf);
+        return (1);
     }
-    add_node_end(&(info->env), buf, 0);
-    free(buf);
     info->env_changed = 1;
     return (0);
 }
@@ -10,67 +10,152 @@ void clear_info(info_t *info)
     info->argv = NULL;
     info->path = NULL;
     info->argc = 0;
+    info->background = 0;
+    info->redir_in = NULL;
+    info->redir_out = NULL;
+    info->redir_append = 0;
 }
 
 /**
- * set_info - initializes info_t struct
+ * set_words - adds the words of an alias expansion to argv
  * @info: struct address
- * @av: argument vector
+ * @val: the expansion
+ * @argv: the argument vector being built
+ * @argc: address of the number of arguments in argv
+ *
+ * Return: argv, grown to make room for the words, or NULL on failure
  */
-void set_info(info_t *info, char **av)
+static char **set_words(info_t *info, char *val, char **argv, int *argc)
 {
-    int i = 0;
+    tokens_t tl = {NULL, 0, 0};
+    char *copy = arena_strdup(&(info->arena), val), **v;
+    size_t n = info->tok_end - info->tok_start, k;
 
-    info->fname = av[0];
-    if (info->arg)
+    if (!copy || lex(copy, &tl) < 0)
     {
-        info->argv = strtow(info->arg, " \t");
-        if (!info->argv)
+        syntax_error(info, "Unterminated quoted string in alias");
+        return (free(tl.v), NULL);
+    }
+    v = arena_alloc(&(info->arena), sizeof(char *) * (n + tl.n + 1));
+    if (v)
+    {
+        for (k = 0; k < (size_t)*argc; k++)
+            v[k] = argv[k];
+        for (k = 0; k < tl.n; k++)
+            v[(*argc)++] = tok_word(info, copy, &tl.v[k]);
+    }
+    free(tl.v);
+    return (v);
+}
+
+/**
+ * set_info - builds argv and the redirections of the current command
+ * @info: struct address
+ *
+ * The command is the token range tok_start to tok_end of info->tokens.
+ * A plain first word that names an alias is replaced by the words of
+ * its expansion.
+ *
+ * Return: 0 on success, -1 on a syntax error
+ */
+int set_info(info_t *info)
+{
+    token_t *t = info->tokens.v;
+    size_t i = info->tok_start, end = info->tok_end;
+    char **argv, *word, *val;
+    int argc = 0;
+
+    info->redir_in = info->redir_out = NULL;
+    info->redir_append = 0;
+    info->argc = 0;
+    info->argv = NULL;
+    argv = arena_alloc(&(info->arena), sizeof(char *) * (end - i + 1));
+    if (!argv)
+        return (-1);
+    for (; i < end; i++)
+    {
+        if (t[i].kind == TOK_WORD)
         {
-            info->argv = malloc(sizeof(char *) * 2);
-            if (info->argv)
-            {
-                info->argv[0] = shell_strdup(info->arg);
-                info->argv[1] = NULL;
-            }
+            word = tok_word(info, info->tok_base, &t[i]);
+            if (!word)
+                return (-1);
+            val = !argc && !t[i].flags ? alias_value(info, word) : NULL;
+            if (val)
+                argv = set_words(info, val, argv, &argc);
+            else
+                argv[argc++] = word;
+            if (!argv)
+                return (-1);
+            continue;
+        }
+        if (t[i].kind < TOK_LESS || t[i].kind > TOK_DGREAT)
+        {
+            syntax_error(info, tok_unexpected(&t[i]));
+            return (-1);
+        }
+        if (i + 1 >= end || t[i + 1].kind != TOK_WORD)
+        {
+            syntax_error(info, tok_unexpected(i + 1 < end ? &t[i + 1] : NULL));
+            return (-1);
+        }
+        word = tok_word(info, info->tok_base, &t[++i]);
+        if (!word)
+            return (-1);
+        if (t[i - 1].kind == TOK_LESS)
+            info->redir_in = word;
+        else
+        {
+            info->redir_out = word;
+            info->redir_append = t[i - 1].kind == TOK_DGREAT;
         }
-        for (i = 0; info->argv && info->argv[i]; i++)
-            ;
-        info->argc = i;
-
-        replace_alias(info);
-        replace_vars(info);
     }
+    argv[argc] = NULL;
+    info->argv = argv;
+    info->argc = argc;
+    return (0);
 }
 
 /**
  * free_info - frees info_t struct fields
  * @info: struct address
  * @all: true if freeing all fields
+ *
+ * argv and its expansions live in info->arena, which is reset here in
+ * one step. Setting HSH_ALLOC_STATS reports the arena usage of each
+ * command on stderr.
  */
 void free_info(info_t *info, int all)
 {
-    ffree(info->argv);
+    if (info->arena.allocs && _getenv(info, "HSH_ALLOC_STATS="))
+        arena_report(&(info->arena));
+    arena_reset(&(info->arena));
     info->argv = NULL;
     info->path = NULL;
     if (all)
     {
         if (!info->cmd_buf)
             free(info->arg);
-        if (info->env)
-            free_list(&(info->env));
-        if (info->history)
-            free_list(&(info->history));
-        if (info->alias)
-            free_list(&(info->alias));
-        if (info->env_array)
-        {
-            ffree(info->env_array);
-            info->env_array = NULL;
-        }
-        ffree(info->cmd_buf);
+        varmap_free(&(info->env));
+        hist_free(&(info->history));
+        varmap_free(&(info->alias));
+        varmap_free(&(info->alias_cache));
+        arena_free(&(info->arena));
+        free(info->tokens.v);
+        info->tokens.v = NULL;
+        info->tokens.n = info->tokens.cap = 0;
+        hash_free(info);
+        free(info->pipestatus);
+        info->pipestatus = NULL;
+#ifndef WINDOWS
+        jobs_free(info);
+#endif
+        bfree((void **)info->cmd_buf);
+#ifndef WINDOWS
+        code_free(&(info->code));
+#endif
+        unmap_input(info);
         if (info->readfd > 2)
             close(info->readfd);
-        _putchar(BUF_FLUSH);
+        stream_flush_all();
     }
 }
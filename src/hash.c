@@ -0,0 +1,256 @@
+#include "shell.h"
+
+/**
+ * hash_name - computes the bucket hash of a command name
+ * @name: the command name
+ *
+ * Return: the hash value
+ */
+static unsigned int hash_name(const char *name)
+{
+    unsigned int h = 5381;
+
+    while (*name)
+        h = ((h << 5) + h) + (unsigned char)*name++;
+    return (h);
+}
+
+/**
+ * hash_grow - doubles the bucket array and rehashes every entry
+ * @tbl: the command hash table
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int hash_grow(cmd_hash_t *tbl)
+{
+    cmd_hash_entry_t **buckets, *e, *next;
+    unsigned int i, size = tbl->size ? tbl->size * 2 : CMD_HASH_SIZE, b;
+
+    buckets = malloc(sizeof(*buckets) * size);
+    if (!buckets)
+        return (-1);
+    _memset((char *)buckets, 0, sizeof(*buckets) * size);
+    for (i = 0; i < tbl->size; i++)
+        for (e = tbl->buckets[i]; e; e = next)
+        {
+            next = e->next;
+            b = hash_name(e->name) & (size - 1);
+            e->next = buckets[b];
+            buckets[b] = e;
+        }
+    free(tbl->buckets);
+    tbl->buckets = buckets;
+    tbl->size = size;
+    return (0);
+}
+
+/**
+ * hash_get - finds the cache entry for a command name
+ * @tbl: the command hash table
+ * @name: the command name
+ *
+ * Return: the entry, or NULL if the name is not cached
+ */
+static cmd_hash_entry_t *hash_get(cmd_hash_t *tbl, char *name)
+{
+    cmd_hash_entry_t *e;
+
+    if (!tbl->size)
+        return (NULL);
+    for (e = tbl->buckets[hash_name(name) & (tbl->size - 1)]; e; e = e->next)
+        if (!_strcmp(e->name, name))
+            return (e);
+    return (NULL);
+}
+
+/**
+ * hash_store - records the location of a command, replacing any old one
+ * @tbl: the command hash table
+ * @name: the command name
+ * @path: the resolved path, or NULL to cache a failed lookup
+ *
+ * Return: the entry, or NULL on allocation failure
+ */
+static cmd_hash_entry_t *hash_store(cmd_hash_t *tbl, char *name, char *path)
+{
+    cmd_hash_entry_t *e = hash_get(tbl, name);
+    char *copy = NULL;
+    unsigned int b;
+
+    if (path)
+    {
+        copy = shell_strdup(path);
+        if (!copy)
+            return (NULL);
+    }
+    if (e)
+    {
+        free(e->path);
+        e->path = copy;
+        e->hits = 0;
+        return (e);
+    }
+    if (tbl->count >= tbl->size && hash_grow(tbl) == -1)
+        return (free(copy), NULL);
+    e = malloc(sizeof(*e));
+    if (!e)
+        return (free(copy), NULL);
+    e->name = shell_strdup(name);
+    if (!e->name)
+        return (free(copy), free(e), NULL);
+    e->path = copy;
+    e->hits = 0;
+    b = hash_name(name) & (tbl->size - 1);
+    e->next = tbl->buckets[b];
+    tbl->buckets[b] = e;
+    tbl->count++;
+    return (e);
+}
+
+/**
+ * hash_find_path - finds a command in PATH through the location cache
+ * @info: the parameter struct
+ * @cmd: the command name
+ *
+ * Names containing a '/' are never cached. A cached path that is no
+ * longer executable is dropped and searched for again.
+ *
+ * Return: full path of cmd if found or NULL
+ */
+char *hash_find_path(info_t *info, char *cmd)
+{
+    cmd_hash_t *tbl = &info->cmd_hash;
+    cmd_hash_entry_t *e;
+    char *path;
+
+    if (_strchr(cmd, '/'))
+        return (find_path(info, _getenv(info, "PATH="), cmd));
+    e = hash_get(tbl, cmd);
+    if (e && (!e->path || is_cmd(info, e->path)))
+    {
+        tbl->hits++;
+        e->hits++;
+        return (e->path);
+    }
+    tbl->misses++;
+    path = find_path(info, _getenv(info, "PATH="), cmd);
+    e = hash_store(tbl, cmd, path);
+    if (!e)
+        return (path);
+    e->hits++;
+    return (e->path);
+}
+
+/**
+ * hash_add - searches PATH for a command and caches the result
+ * @info: the parameter struct
+ * @cmd: the command name
+ *
+ * Return: 0 if the command was found, 1 otherwise
+ */
+int hash_add(info_t *info, char *cmd)
+{
+    char *path;
+
+    if (_strchr(cmd, '/'))
+        return (0);
+    path = find_path(info, _getenv(info, "PATH="), cmd);
+    if (!path)
+        return (1);
+    return (hash_store(&info->cmd_hash, cmd, path) == NULL);
+}
+
+/**
+ * hash_reset - forgets every cached command location
+ * @info: the parameter struct
+ */
+void hash_reset(info_t *info)
+{
+    cmd_hash_t *tbl = &info->cmd_hash;
+    cmd_hash_entry_t *e, *next;
+    unsigned int i;
+
+    for (i = 0; i < tbl->size; i++)
+    {
+        for (e = tbl->buckets[i]; e; e = next)
+        {
+            next = e->next;
+            free(e->name);
+            free(e->path);
+            free(e);
+        }
+        tbl->buckets[i] = NULL;
+    }
+    tbl->count = 0;
+}
+
+/**
+ * hash_free - releases the command location cache
+ * @info: the parameter struct
+ */
+void hash_free(info_t *info)
+{
+    hash_reset(info);
+    free(info->cmd_hash.buckets);
+    info->cmd_hash.buckets = NULL;
+    info->cmd_hash.size = 0;
+}
+
+/**
+ * _myhash - mimics the hash builtin
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *
+ * With no arguments lists the cached commands, -r empties the cache,
+ * -s prints the hit and miss counters, and names are looked up and added.
+ *
+ * Return: 0 on success, 1 if a name was not found
+ */
+int _myhash(info_t *info)
+{
+    cmd_hash_t *tbl = &info->cmd_hash;
+    cmd_hash_entry_t *e;
+    unsigned int i, shown = 0;
+    int ret = 0;
+
+    if (info->argc == 1)
+    {
+        for (i = 0; i < tbl->size; i++)
+            for (e = tbl->buckets[i]; e; e = e->next)
+            {
+                if (!e->path)
+                    continue;
+                if (!shown++)
+                    _puts("hits\tcommand\n");
+                _puts(convert_number(e->hits, 10, 0));
+                _putchar('\t');
+                _puts(e->path);
+                _putchar('\n');
+            }
+        if (!shown)
+            _puts("hash: hash table empty\n");
+        return (0);
+    }
+    for (i = 1; info->argv[i]; i++)
+    {
+        if (!_strcmp(info->argv[i], "-r"))
+            hash_reset(info);
+        else if (!_strcmp(info->argv[i], "-s"))
+        {
+            _puts("hits: ");
+            _puts(convert_number(tbl->hits, 10, 0));
+            _puts(", misses: ");
+            _puts(convert_number(tbl->misses, 10, 0));
+            _puts(", entries: ");
+            _puts(convert_number(tbl->count, 10, 0));
+            _putchar('\n');
+        }
+        else if (hash_add(info, info->argv[i]))
+        {
+            print_error(info, info->argv[i]);
+            _eputs(": not found\n");
+            ret = 1;
+        }
+    }
+    return (ret);
+}
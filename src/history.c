@@ -1,141 +1,858 @@
 #include "shell.h"
+#include <time.h>
+#ifndef WINDOWS
+#include <sys/file.h>
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/*
+ * The history file is a hist_header_t followed by one record per command
+ * line, appended when the line has run. A record is a hist_rec_t, then
+ * the working directory and the command, each NUL terminated, padded to
+ * HIST_ALIGN; its size covers all of that, so records are walked without
+ * looking inside them. The layout is native. A file with another magic,
+ * format or record size is not read or appended to.
+ */
+#define HIST_MAGIC 0x48534848 /* "HHSH" */
+#define HIST_FORMAT 1
+#define HIST_ALIGN 8
 
 /**
- * get_history_file - gets the history file
+ * struct hist_header - the start of the history file
+ * @magic: HIST_MAGIC
+ * @format: HIST_FORMAT
+ * @rec_size: sizeof(hist_rec_t)
+ * @align: HIST_ALIGN
+ */
+typedef struct hist_header
+{
+    unsigned int magic;
+    unsigned int format;
+    unsigned int rec_size;
+    unsigned int align;
+} hist_header_t;
+
+/**
+ * struct hist_rec - the fixed part of a history record
+ * @size: size of the whole record, padding included
+ * @status: exit status, -1 if unknown
+ * @start: start time in microseconds since the epoch, 0 if unknown
+ * @wall: wall-clock duration in microseconds, -1 if unknown
+ * @cpu: CPU time in microseconds, -1 if unknown
+ * @cwd_len: length of the working directory that follows
+ * @cmd_len: length of the command that follows it
+ */
+typedef struct hist_rec
+{
+    unsigned int size;
+    int status;
+    long long start;
+    long long wall;
+    long long cpu;
+    unsigned int cwd_len;
+    unsigned int cmd_len;
+} hist_rec_t;
+
+#ifdef WINDOWS
+typedef struct _stat64i32 hist_stat_t;
+#else
+typedef struct stat hist_stat_t;
+#endif
+
+static const hist_header_t hist_header = {
+    HIST_MAGIC, HIST_FORMAT, sizeof(hist_rec_t), HIST_ALIGN
+};
+
+/**
+ * hist_path - builds the name of a file in the home directory
  * @info: parameter struct
- * Return: allocated string containing history file
+ * @name: the file name
+ *
+ * Return: allocated path, or NULL if HOME is not set
  */
-char *get_history_file(info_t *info)
+static char *hist_path(info_t *info, const char *name)
 {
     char *buf, *dir;
 
     dir = _getenv(info, "HOME=");
     if (!dir)
         return (NULL);
-    buf = malloc(sizeof(char) * (_strlen(dir) + _strlen(HIST_FILE) + 2));
+    buf = malloc(sizeof(char) * (_strlen(dir) + _strlen((char *)name) + 2));
     if (!buf)
         return (NULL);
     buf[0] = 0;
     _strcpy(buf, dir);
     _strcat(buf, "/");
-    _strcat(buf, HIST_FILE);
+    _strcat(buf, (char *)name);
     return (buf);
 }
 
 /**
- * write_history - creates a file, or appends to an existing file
+ * get_history_file - gets the history file
+ * @info: parameter struct
+ * Return: allocated string containing history file
+ */
+char *get_history_file(info_t *info)
+{
+    return (hist_path(info, HIST_FILE));
+}
+
+/**
+ * hist_clock - reads a clock in microseconds
+ * @mono: on for the monotonic clock, off for the time of day
+ *
+ * Return: the time
+ */
+static long long hist_clock(int mono)
+{
+#ifndef WINDOWS
+    struct timespec ts;
+
+    clock_gettime(mono ? CLOCK_MONOTONIC : CLOCK_REALTIME, &ts);
+    return (ts.tv_sec * 1000000LL + ts.tv_nsec / 1000);
+#else
+    return (mono ? (long long)GetTickCount64() * 1000
+            : (long long)time(NULL) * 1000000);
+#endif
+}
+
+/**
+ * hist_rec_size - gets the size of a record
+ * @cwd_len: length of its working directory
+ * @cmd_len: length of its command
+ *
+ * Return: the size, padding included
+ */
+static size_t hist_rec_size(size_t cwd_len, size_t cmd_len)
+{
+    size_t n = sizeof(hist_rec_t) + cwd_len + 1 + cmd_len + 1;
+
+    return ((n + HIST_ALIGN - 1) & ~(size_t)(HIST_ALIGN - 1));
+}
+
+/**
+ * hist_rec_ok - checks a record read from the history file
+ * @p: the record
+ * @n: number of bytes available at p, at least sizeof(hist_rec_t)
+ *
+ * Return: size of the record, 0 if it is not all there, -1 if malformed
+ */
+static ssize_t hist_rec_ok(const char *p, size_t n)
+{
+    hist_rec_t r;
+
+    memcpy(&r, p, sizeof(r));
+    if (r.size != hist_rec_size(r.cwd_len, r.cmd_len))
+        return (-1);
+    if (r.size > n)
+        return (0);
+    if (p[sizeof(r) + r.cwd_len] || p[sizeof(r) + r.cwd_len + 1 + r.cmd_len])
+        return (-1);
+    return (r.size);
+}
+
+/**
+ * hist_parse - adds the commands of a run of records to the history
+ * @h: the history
+ * @buf: the records
+ * @n: number of bytes at buf
+ * @base: offset of buf in the file
+ *
+ * The records this shell wrote after another shell's, at h->own_off, are
+ * held already and are skipped.
+ *
+ * Return: number of bytes consumed; a trailing record not all there is
+ *         left for later, while everything after a malformed one is
+ *         consumed without being added
+ */
+static size_t hist_parse(history_t *h, char *buf, size_t n, size_t base)
+{
+    hist_rec_t r;
+    hist_meta_t m;
+    size_t p = 0, at;
+    ssize_t k = 0;
+
+    while (n - p >= sizeof(r) && (k = hist_rec_ok(buf + p, n - p)) > 0)
+    {
+        at = base + p;
+        if (at < h->own_off || at >= h->own_off + h->own_len)
+        {
+            memcpy(&r, buf + p, sizeof(r));
+            m.start = r.start;
+            m.wall = r.wall;
+            m.cpu = r.cpu;
+            m.status = r.status;
+            hist_add(h, buf + p + sizeof(r) + r.cwd_len + 1,
+                    buf + p + sizeof(r), &m);
+        }
+        h->records++;
+        p += k;
+    }
+    return (k == -1 && n - p >= sizeof(r) ? n : p);
+}
+
+/**
+ * hist_rec_put - appends a record to a descriptor's stream
+ * @fd: the descriptor
+ * @cmd: the command
+ * @cwd: the working directory it ran in
+ * @m: what is known of it
+ *
+ * The record is built whole and goes to the stream in one piece, so it
+ * is never split between two writes.
+ *
+ * Return: size of the record, 0 on allocation failure
+ */
+static size_t hist_rec_put(int fd, const char *cmd, const char *cwd,
+        const hist_meta_t *m)
+{
+    hist_rec_t r;
+    char *buf;
+
+    r.cwd_len = _strlen((char *)cwd);
+    r.cmd_len = _strlen((char *)cmd);
+    r.size = hist_rec_size(r.cwd_len, r.cmd_len);
+    r.status = m->status;
+    r.start = m->start;
+    r.wall = m->wall;
+    r.cpu = m->cpu;
+    buf = malloc(r.size);
+    if (!buf)
+        return (0);
+    _memset(buf, 0, r.size);
+    memcpy(buf, &r, sizeof(r));
+    memcpy(buf + sizeof(r), cwd, r.cwd_len);
+    memcpy(buf + sizeof(r) + r.cwd_len + 1, cmd, r.cmd_len);
+    stream_write(fd, buf, r.size);
+    free(buf);
+    return (r.size);
+}
+
+/**
+ * hist_create - creates the history file, importing the old text one
  * @info: the parameter struct
- * Return: 1 on success, else -1
+ * @file: name of the history file
+ *
+ * The file is written under a temporary name and then linked into place,
+ * so it is never seen half written and, of several shells starting at
+ * once, one creates it. Each line of HIST_TEXT_FILE becomes a record
+ * whose time, durations and status are unknown; the text file is left
+ * as it was.
  */
-int write_history(info_t *info)
+static void hist_create(info_t *info, char *file)
 {
-    ssize_t fd;
-    char *filename = get_history_file(info);
-    list_t *node = NULL;
+    hist_meta_t m = {0, 0, -1, -1, -1};
+    char *text = hist_path(info, HIST_TEXT_FILE), *tmp, *buf = NULL;
+    char *p, *nl;
+    ssize_t fd, size = 0, r = -1;
+    hist_stat_t st;
 
-    if (!filename)
+    fd = text ? open(text, O_RDONLY | O_CLOEXEC) : -1;
+    free(text);
+    if (fd != -1)
+    {
+        size = fstat(fd, &st) ? 0 : st.st_size;
+        buf = size > 0 ? malloc(size + 1) : NULL;
+        r = buf ? read(fd, buf, size) : -1;
+        close(fd);
+    }
+    tmp = malloc(_strlen(file) + 24);
+    if (!tmp)
+    {
+        free(buf);
+        return;
+    }
+    _strcpy(tmp, file);
+    _strcat(tmp, ".");
+    _strcat(tmp, convert_number(getpid(), 10, 0));
+    fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd != -1)
+    {
+        stream_setbuf(fd, HIST_BUF_SIZE);
+        stream_write(fd, (const char *)&hist_header, sizeof(hist_header));
+        for (p = buf; r == size && p < buf + size; p = nl + 1)
+        {
+            nl = memchr(p, '\n', buf + size - p);
+            nl = nl ? nl : buf + size;
+            *nl = 0;
+            hist_rec_put(fd, p, "", &m);
+        }
+        stream_setbuf(fd, 0);
+        close(fd);
+#ifndef WINDOWS
+        link(tmp, file);
+        unlink(tmp);
+#else
+        if (rename(tmp, file) == -1)
+            unlink(tmp);
+#endif
+    }
+    free(tmp);
+    free(buf);
+}
+
+/**
+ * hist_open - opens the history file for appending, once
+ * @info: the parameter struct
+ *
+ * The file is opened again when another shell has compacted it and
+ * renamed a new one in; what this shell had read of the old one then no
+ * longer counts. The new file takes the old one's descriptor, so records
+ * still in its stream go to the new file. It is created if missing, and
+ * given its header again if empty.
+ *
+ * Return: size of the file, or -1 if it cannot be opened
+ */
+static ssize_t hist_open(info_t *info)
+{
+    history_t *h = &(info->history);
+    char *filename;
+    ssize_t size = 0;
+    int renamed = 0, fd;
+    hist_stat_t st;
+
+    if (h->fd >= 0 && !fstat(h->fd, &st))
+    {
+        if (st.st_nlink)
+            return (st.st_size);
+        renamed = 1;
+    }
+    if (h->fd == -1 || renamed)
+    {
+        filename = get_history_file(info);
+        fd = filename ? open(filename, O_RDWR | O_APPEND | O_CLOEXEC) : -1;
+        if (fd == -1 && filename && errno == ENOENT)
+        {
+            hist_create(info, filename);
+            fd = open(filename, O_RDWR | O_APPEND | O_CLOEXEC);
+        }
+        free(filename);
+        if (renamed && fd != -1 && dup2(fd, h->fd) != -1)
+        {
+#ifndef WINDOWS
+            fcntl(h->fd, F_SETFD, FD_CLOEXEC);
+#endif
+            close(fd);
+            fd = h->fd;
+            h->own_len = 0;
+        }
+        else if (renamed)
+        {
+            stream_setbuf(h->fd, 0);
+            close(h->fd);
+            h->fd = -1;
+        }
+        if (fd == -1)
+            return (h->fd = -2, -1); /* do not retry for every command */
+        if (h->fd == -1)
+        {
+            h->fd = fd;
+            stream_setbuf(h->fd, HIST_BUF_SIZE);
+            stream_hold(h->fd);
+        }
+        if (!fstat(h->fd, &st))
+            size = st.st_size;
+        if (renamed || (size_t)size < h->off)
+            h->off = size;
+        if (!size) /* emptied to clear the history */
+            h->unsaved += stream_write(h->fd, (const char *)&hist_header,
+                    sizeof(hist_header));
+    }
+    return (h->fd < 0 ? -1 : size);
+}
+
+/**
+ * hist_lock - takes a shared lock on the history file before writing
+ * @info: the parameter struct
+ *
+ * Shells append under shared locks and compaction takes an exclusive
+ * one from reading the file until its copy is renamed in, so no record
+ * is appended to a file about to be replaced. A file compacted while
+ * waiting is opened again. Where locks are not supported, writes go
+ * ahead without one.
+ *
+ * Return: 0 if the history file can be written, -1 otherwise
+ */
+static int hist_lock(info_t *info)
+{
+#ifndef WINDOWS
+    history_t *h = &(info->history);
+    hist_stat_t st;
+
+    while (hist_open(info) >= 0)
+    {
+        if (flock(h->fd, LOCK_SH) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            return (0);
+        }
+        if (fstat(h->fd, &st) || st.st_nlink)
+            return (0);
+        flock(h->fd, LOCK_UN);
+    }
+    return (-1);
+#else
+    return (hist_open(info) < 0 ? -1 : 0);
+#endif
+}
+
+/**
+ * hist_unlock - releases the lock taken by hist_lock()
+ * @h: the history
+ */
+static void hist_unlock(history_t *h)
+{
+#ifndef WINDOWS
+    flock(h->fd, LOCK_UN);
+#else
+    (void)h;
+#endif
+}
+
+/**
+ * hist_save - writes out the records not in the history file yet
+ * @info: the parameter struct
+ *
+ * The file is opened with O_APPEND, so every save lands at its end even
+ * while other shells append to it too, and the records go out in a
+ * single write, under hist_lock(). An interactive shell saves each line
+ * once it has run and so loses nothing if it is killed; a script saves
+ * when the buffer would fill and at exit.
+ *
+ * Return: 0 on success, -1 on error
+ */
+int hist_save(info_t *info)
+{
+    history_t *h = &(info->history);
+#ifndef WINDOWS
+    off_t end;
+#endif
+
+    if (h->fd < 0 || !h->unsaved)
+        return (h->fd == -2 ? -1 : 0);
+    if (hist_lock(info) == -1)
         return (-1);
+    stream_flush(h->fd);
+#ifndef WINDOWS
+    if (h->shared && (end = lseek(h->fd, 0, SEEK_CUR)) != -1)
+    {
+        /* the kernel placed the write; see whether another came first */
+        if ((size_t)end - h->unsaved == h->off)
+            h->off = end;
+        else
+            h->own_off = end - h->unsaved, h->own_len = h->unsaved;
+    }
+#endif
+    hist_unlock(h);
+    h->unsaved = 0;
+    return (0);
+}
 
-    fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
-    free(filename);
+/**
+ * hist_sync - adds the commands other shells appended to the history file
+ * @info: the parameter struct
+ *
+ * Only done in shared mode, which HSH_HISTSHARE turns on when an
+ * interactive shell starts. Just the bytes past h->off are read, so when
+ * no other shell wrote the check is a single fstat(). Commands this shell
+ * wrote itself are already held and are skipped.
+ */
+void hist_sync(info_t *info)
+{
+#ifndef WINDOWS
+    history_t *h = &(info->history);
+    char *buf;
+    ssize_t size, r;
+
+    if (!h->shared || h->fd == -2)
+        return;
+    size = hist_open(info);
+    if (size <= 0 || (size_t)size <= h->off)
+        return;
+    buf = malloc(size - h->off);
+    if (!buf)
+        return;
+    do {
+        r = pread(h->fd, buf, size - h->off, h->off);
+    } while (r == -1 && errno == EINTR);
+    if (r > 0)
+        h->off += hist_parse(h, buf, r, h->off);
+    if (h->off >= h->own_off + h->own_len)
+        h->own_len = 0;
+    free(buf);
+#else
+    (void)info;
+#endif
+}
+
+/**
+ * hist_end - records how the command line being run ended
+ * @info: the parameter struct
+ * @done: off when the line is only followed by more of the same command,
+ *        whose status is then not the line's own
+ *
+ * The CPU time is that of the processes reaped since the previous line
+ * ended, which are those the line ran; the shell's own is not counted.
+ */
+void hist_end(info_t *info, int done)
+{
+    history_t *h = &(info->history);
+    hist_meta_t *m;
+    long long cpu;
+    size_t i, n;
+    char *cmd;
+    int locked;
+
+    if (!h->pending)
+        return;
+#ifndef WINDOWS
+    cpu = children_cpu();
+#else
+    cpu = -1;
+#endif
+    if (h->pending > h->first)
+    {
+        i = h->pending - 1 - h->first;
+        m = hist_meta(h, i);
+        m->wall = hist_clock(1) - h->clock;
+        m->cpu = cpu < 0 || h->cpu_mark < 0 ? -1 : cpu - h->cpu_mark;
+        m->status = done ? info->status : -1;
+        if (h->fd == -1 || interactive(info))
+            hist_open(info); /* a script checks for a new file only once */
+        cmd = hist_get(h, i);
+        n = hist_rec_size(_strlen(cmd + _strlen(cmd) + 1), _strlen(cmd));
+        if (h->fd >= 0 && h->unsaved + n > HIST_BUF_SIZE)
+            hist_save(info); /* not by the stream when full, unlocked */
+        locked = h->fd >= 0 && n > HIST_BUF_SIZE && !hist_lock(info);
+        if (h->fd >= 0)
+        {
+            h->unsaved += hist_rec_put(h->fd, cmd, cmd + _strlen(cmd) + 1, m);
+            h->records++;
+        }
+        if (locked) /* the record went out by itself */
+            hist_unlock(h);
+    }
+    h->cpu_mark = cpu;
+    h->pending = 0;
+    if (interactive(info))
+        hist_save(info);
+}
+
+/**
+ * hist_compact - cuts the history file down to its last HIST_MAX records
+ * @file: the history file
+ *
+ * The kept records are written to a temporary file that is renamed over
+ * the history file, so a reader never sees it half written. The name of
+ * the temporary file holds the pid, so shells compacting at once do not
+ * write into each other's. The history file stays locked from the read
+ * to the rename, which holds off the shells appending to it; a file that
+ * another shell already compacted meanwhile is left alone.
+ */
+static void hist_compact(char *file)
+{
+    char *buf = NULL, *tmp;
+    ssize_t fd, out, size = 0, r = -1, k;
+    size_t n = 0, p, keep;
+    hist_stat_t st;
+
+    while ((fd = open(file, O_RDONLY | O_CLOEXEC)) != -1)
+    {
+#ifndef WINDOWS
+        while (flock(fd, LOCK_EX) == -1 && errno == EINTR)
+            ;
+#endif
+        if (fstat(fd, &st) || st.st_nlink)
+            break;
+        close(fd); /* renamed over by another shell while waiting */
+    }
     if (fd == -1)
+        return;
+    size = fstat(fd, &st) ? 0 : st.st_size;
+    buf = size >= (ssize_t)sizeof(hist_header) ? malloc(size) : NULL;
+    r = buf ? read(fd, buf, size) : -1;
+    tmp = malloc(_strlen(file) + 24);
+    if (r == size && tmp && !memcmp(buf, &hist_header, sizeof(hist_header)))
+    {
+        for (p = sizeof(hist_header); size - p >= sizeof(hist_rec_t)
+                && (k = hist_rec_ok(buf + p, size - p)) > 0; p += k)
+            n++;
+        keep = p; /* a malformed tail is dropped */
+        for (p = sizeof(hist_header); n > HIST_MAX; n--)
+            p += hist_rec_ok(buf + p, keep - p);
+        _strcpy(tmp, file);
+        _strcat(tmp, ".");
+        _strcat(tmp, convert_number(getpid(), 10, 0));
+        out = p > sizeof(hist_header) || keep < (size_t)size ? open(tmp,
+                O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644) : -1;
+        keep -= p;
+        if (out != -1)
+        {
+            /* the header goes right before the first record kept */
+            memcpy(buf + p - sizeof(hist_header), &hist_header,
+                    sizeof(hist_header));
+            r = write(out, buf + p - sizeof(hist_header),
+                    keep + sizeof(hist_header));
+            if (close(out) == -1 || r != (ssize_t)(keep + sizeof(hist_header))
+                    || rename(tmp, file) == -1)
+                unlink(tmp);
+        }
+    }
+    close(fd); /* only now may appends go on, to the new file */
+    free(tmp);
+    free(buf);
+}
+
+/**
+ * write_history - saves the rest of the history and closes its file
+ * @info: the parameter struct
+ *
+ * Once the file holds more than HIST_MAX times HSH_HISTCOMPACT (default
+ * HIST_COMPACT) records, it is compacted by a child process so that exit
+ * does not wait on it. The child starts a session of its own with its
+ * standard descriptors on /dev/null, so neither does a reader of the
+ * shell's output.
+ *
+ * Return: 1 on success, else -1
+ */
+int write_history(info_t *info)
+{
+    history_t *h = &(info->history);
+    char *filename, *factor = _getenv(info, "HSH_HISTCOMPACT=");
+    size_t limit = HIST_MAX * (size_t)(factor && _atoi(factor) > 0
+            ? _atoi(factor) : HIST_COMPACT);
+    int r;
+
+    hist_end(info, 1);
+    r = hist_save(info);
+    if (h->fd >= 0)
+    {
+        stream_setbuf(h->fd, 0);
+        close(h->fd);
+        h->fd = -1;
+    }
+    if (r == -1 || h->records <= limit)
+        return (r == -1 ? -1 : 1);
+    filename = get_history_file(info);
+    if (!filename)
         return (-1);
-    for (node = info->history; node; node = node->next)
+#ifndef WINDOWS
+    if (fork() == 0)
     {
-        _putsfd(node->str, fd);
-        _putfd('\n', fd);
+        int fd;
+
+        /* let go of the shell's output, so no reader waits for this */
+        setsid();
+        fd = open("/dev/null", O_RDWR);
+        for (r = 0; fd != -1 && r < 3; r++)
+            dup2(fd, r);
+        if (fd > 2)
+            close(fd);
+        hist_compact(filename);
+        _exit(0);
     }
-    _putfd(BUF_FLUSH, fd);
-    close(fd);
+#else
+    hist_compact(filename);
+#endif
+    free(filename);
     return (1);
 }
 
 /**
  * read_history - reads history from file
  * @info: the parameter struct
- * Return: histcount on success, 0 otherwise
+ *
+ * The file is created, with the commands of the old text history, if it
+ * does not exist. Also turns shared mode on when asked for; hist_sync()
+ * then goes on from where this read stopped.
+ *
+ * Return: number of commands held on success, 0 otherwise
  */
 int read_history(info_t *info)
 {
-    int i, last = 0, linecount = 0;
-    ssize_t fd, rdlen, fsize = 0;
+    history_t *h = &(info->history);
+    ssize_t fd, rdlen = -1, fsize = 0;
     char *buf = NULL, *filename = get_history_file(info);
-#ifdef WINDOWS
-    struct _stat64i32 st;
-#else
-    struct stat st;
-#endif
+    hist_stat_t st;
 
+    h->shared = info->tty && _getenv(info, "HSH_HISTSHARE=");
     if (!filename)
         return (0);
-
-    fd = open(filename, O_RDONLY);
+    fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if (fd == -1 && errno == ENOENT)
+    {
+        hist_create(info, filename);
+        fd = open(filename, O_RDONLY | O_CLOEXEC);
+    }
     free(filename);
     if (fd == -1)
         return (0);
     if (!fstat(fd, &st))
         fsize = st.st_size;
-    if (fsize < 2)
+    if (fsize >= (ssize_t)sizeof(hist_header))
+        buf = malloc(fsize);
+    if (buf)
+        rdlen = read(fd, buf, fsize);
+    close(fd);
+    if (!fsize)
         return (0);
-    buf = malloc(sizeof(char) * (fsize + 1));
-    if (!buf)
+    if (rdlen != fsize || memcmp(buf, &hist_header, sizeof(hist_header)))
+    {
+        free(buf);
+        h->fd = -2; /* not a file this shell knows how to append to */
         return (0);
-    rdlen = read(fd, buf, fsize);
-    buf[fsize] = 0;
-    if (rdlen <= 0)
-        return (free(buf), 0);
-    close(fd);
-    for (i = 0; i < fsize; i++)
-        if (buf[i] == '\n')
-        {
-            buf[i] = 0;
-            build_history_list(info, buf + last, linecount++);
-            last = i + 1;
-        }
-    if (last != i)
-        build_history_list(info, buf + last, linecount++);
+    }
+    h->off = sizeof(hist_header) + hist_parse(h, buf + sizeof(hist_header),
+            fsize - sizeof(hist_header), sizeof(hist_header));
     free(buf);
-    info->histcount = linecount;
-    while (info->histcount-- >= HIST_MAX)
-        delete_node_at_index(&(info->history), 0);
-    renumber_history(info);
-    return (info->histcount);
+    h->first = 0;
+    if (info->tty)
+        hist_index_build(h); /* kept up to date by hist_add() from now on */
+    return (h->count);
 }
 
 /**
- * build_history_list - adds entry to a history linked list
+ * build_history_list - adds a command line read from input to the history
  * @info: Structure containing potential arguments
- * @buf: buffer
- * @linecount: the history linecount, histcount
+ * @buf: the command line
+ *
+ * Its record is written by hist_end() once it has run.
+ *
  * Return: Always 0
  */
-int build_history_list(info_t *info, char *buf, int linecount)
+int build_history_list(info_t *info, char *buf)
 {
-    list_t *node = NULL;
-
-    if (info->history)
-        node = info->history;
-    add_node_end(&node, buf, linecount);
+    history_t *h = &(info->history);
+    hist_meta_t m = {0, 0, -1, -1, -1};
+    char *cwd = _getenv(info, "PWD="), dir[1024];
 
-    if (!info->history)
-        info->history = node;
+    hist_end(info, 0); /* the line before only began this command */
+    hist_sync(info); /* so the commands stay in the order of the file */
+    if (!cwd)
+        cwd = getcwd(dir, sizeof(dir)) ? dir : "";
+    m.start = hist_clock(0);
+    if (hist_add(h, buf, cwd, &m) == 0)
+    {
+        h->pending = h->first + h->count;
+        h->clock = hist_clock(1);
+    }
     return (0);
 }
 
 /**
- * renumber_history - renumbers the history linked list after changes
- * @info: Structure containing potential arguments
- * Return: the new histcount
+ * hist_add - appends a command to a history ring
+ * @h: the history
+ * @cmd: the command
+ * @cwd: the working directory it ran in
+ * @m: what is known of it, NULL for nothing
+ *
+ * Once HIST_MAX commands are held the oldest is dropped. Its text stays
+ * in front of the live commands until the buffer fills; then the live
+ * text is moved down if that frees at least half of the buffer, and the
+ * buffer is doubled otherwise, so each command is copied O(1) times.
+ *
+ * Return: 0 on success, -1 on allocation failure
  */
-int renumber_history(info_t *info)
+int hist_add(history_t *h, const char *cmd, const char *cwd,
+        const hist_meta_t *m)
 {
-    list_t *node = info->history;
-    int i = 0;
+    static const hist_meta_t unknown = {0, 0, -1, -1, -1};
+    size_t k = _strlen((char *)cmd) + 1, n = k + _strlen((char *)cwd) + 1;
+    size_t start, cap, slot;
+    long long latest = h->count ? hist_meta(h, h->count - 1)->latest : 0;
+    char *text;
 
-    while (node)
+    if (!h->ring)
+    {
+        h->ring = malloc(sizeof(*h->ring) * HIST_MAX);
+        h->meta = malloc(sizeof(*h->meta) * HIST_MAX);
+        if (!h->ring || !h->meta)
+            return (free(h->ring), free(h->meta), h->ring = NULL, -1);
+    }
+    if (h->count == HIST_MAX)
     {
-        node->num = i++;
-        node = node->next;
+        h->head = (h->head + 1) % HIST_MAX;
+        h->count--;
+        h->first++;
     }
-    return (info->histcount = i);
+    if (h->len + n > h->cap)
+    {
+        start = h->count ? h->ring[h->head] - h->shift : h->len;
+        if (h->len - start + n <= h->cap / 2)
+        {
+            memmove(h->text, h->text + start, h->len - start);
+            h->len -= start;
+            h->shift += start;
+        }
+        else
+        {
+            for (cap = h->cap ? h->cap * 2 : 4096; h->len + n > cap;)
+                cap *= 2;
+            text = realloc(h->text, cap);
+            if (!text)
+                return (-1);
+            h->text = text;
+            h->cap = cap;
+        }
+    }
+    memcpy(h->text + h->len, cmd, k);
+    memcpy(h->text + h->len + k, cwd, n - k);
+    slot = (h->head + h->count) % HIST_MAX;
+    h->ring[slot] = h->len + h->shift;
+    h->meta[slot] = m ? *m : unknown;
+    if (h->meta[slot].start > latest)
+        latest = h->meta[slot].start;
+    h->meta[slot].latest = latest;
+    h->len += n;
+    h->count++;
+    if (h->index)
+        hist_index_add(h, h->count - 1);
+    return (0);
+}
+
+/**
+ * hist_get - gets a command of a history ring
+ * @h: the history
+ * @i: index of the command, 0 for the oldest
+ *
+ * The working directory it ran in follows its terminating NUL.
+ *
+ * Return: the command, or NULL if i is out of range
+ */
+char *hist_get(history_t *h, size_t i)
+{
+    if (i >= h->count)
+        return (NULL);
+    return (h->text + h->ring[(h->head + i) % HIST_MAX] - h->shift);
+}
+
+/**
+ * hist_meta - gets what is known of a command of a history ring
+ * @h: the history
+ * @i: index of the command, 0 for the oldest
+ *
+ * Return: the command's times and status, or NULL if i is out of range
+ */
+hist_meta_t *hist_meta(history_t *h, size_t i)
+{
+    if (i >= h->count)
+        return (NULL);
+    return (&h->meta[(h->head + i) % HIST_MAX]);
+}
+
+/**
+ * hist_free - frees a history ring
+ * @h: the history
+ */
+void hist_free(history_t *h)
+{
+    free(h->text);
+    free(h->ring);
+    free(h->meta);
+    hist_index_free(h->index);
+    _memset((char *)h, 0, sizeof(*h));
 }
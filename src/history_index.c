@@ -0,0 +1,298 @@
+#include "shell.h"
+
+/*
+ * The trigram index maps every three consecutive bytes of a held command
+ * to the numbers of the commands that contain them, oldest first. A
+ * search for a pattern of three bytes or more only looks at the commands
+ * in the shortest list of its trigrams that are also in every other one,
+ * looked up from the next shortest on, and checks those with strstr().
+ * Numbers of dropped commands are skipped and are cut from the front of
+ * a list once they make up half of it.
+ */
+
+/**
+ * struct hist_post - the commands holding one trigram
+ * @key: the trigram, first byte highest; 0 for an empty slot
+ * @seq: numbers of the commands, oldest first
+ * @n: number of numbers
+ * @cap: size of seq
+ */
+typedef struct hist_post
+{
+    unsigned int key;
+    unsigned long *seq;
+    size_t n;
+    size_t cap;
+} hist_post_t;
+
+/**
+ * struct hist_index - a hash table of trigrams with open addressing
+ * @slots: the table
+ * @size: number of slots, a power of two
+ * @used: number of slots taken
+ */
+struct hist_index
+{
+    hist_post_t *slots;
+    size_t size;
+    size_t used;
+};
+
+/**
+ * post_slot - finds the slot of a trigram
+ * @x: the index
+ * @key: the trigram
+ *
+ * Return: its slot, or the empty slot where it would go
+ */
+static hist_post_t *post_slot(hist_index_t *x, unsigned int key)
+{
+    size_t i = (key * 2654435761u) & (x->size - 1);
+
+    while (x->slots[i].key && x->slots[i].key != key)
+        i = (i + 1) & (x->size - 1);
+    return (&x->slots[i]);
+}
+
+/**
+ * post_grow - doubles the table of an index
+ * @x: the index
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int post_grow(hist_index_t *x)
+{
+    hist_post_t *old = x->slots;
+    size_t i, n = x->size;
+
+    x->slots = calloc(n * 2, sizeof(*x->slots));
+    if (!x->slots)
+        return (x->slots = old, -1);
+    x->size = n * 2;
+    for (i = 0; i < n; i++)
+        if (old[i].key)
+            *post_slot(x, old[i].key) = old[i];
+    free(old);
+    return (0);
+}
+
+/**
+ * post_live - finds the first number in a list not yet dropped
+ * @p: the list
+ * @first: number of the oldest command held
+ *
+ * Return: its position, p->n if there is none
+ */
+static size_t post_live(hist_post_t *p, unsigned long first)
+{
+    size_t lo = 0, hi = p->n, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (p->seq[mid] < first)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo);
+}
+
+/**
+ * hist_index_add - adds a command to the trigram index of a history
+ * @h: the history
+ * @i: index of the command, newer than any indexed so far
+ *
+ * Called by hist_add() for each command once the index exists, so the
+ * index is never rebuilt.
+ */
+void hist_index_add(history_t *h, size_t i)
+{
+    hist_index_t *x = h->index;
+    unsigned long seq = h->first + i, *grown;
+    unsigned char *s = (unsigned char *)hist_get(h, i);
+    hist_post_t *p;
+    unsigned int key;
+    size_t dead, cap;
+
+    for (; s[0] && s[1] && s[2]; s++)
+    {
+        key = (unsigned int)s[0] << 16 | s[1] << 8 | s[2];
+        if (x->used * 2 >= x->size && post_grow(x) == -1)
+            return;
+        p = post_slot(x, key);
+        if (!p->key)
+            p->key = key, x->used++;
+        if (p->n && p->seq[p->n - 1] == seq)
+            continue; /* the trigram occurs twice in this command */
+        if (p->n == p->cap)
+        {
+            dead = post_live(p, h->first);
+            if (dead * 2 >= p->n && dead)
+            {
+                memmove(p->seq, p->seq + dead, (p->n - dead) * sizeof(*p->seq));
+                p->n -= dead;
+            }
+            else
+            {
+                cap = p->cap ? p->cap * 2 : 4;
+                grown = realloc(p->seq, cap * sizeof(*p->seq));
+                if (!grown)
+                    return;
+                p->seq = grown;
+                p->cap = cap;
+            }
+        }
+        p->seq[p->n++] = seq;
+    }
+}
+
+/**
+ * hist_index_build - indexes every command held in a history
+ * @h: the history
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+int hist_index_build(history_t *h)
+{
+    size_t i;
+
+    if (h->index)
+        return (0);
+    h->index = malloc(sizeof(*h->index));
+    if (!h->index)
+        return (-1);
+    h->index->size = 1024;
+    h->index->used = 0;
+    h->index->slots = calloc(h->index->size, sizeof(*h->index->slots));
+    if (!h->index->slots)
+        return (free(h->index), h->index = NULL, -1);
+    for (i = 0; i < h->count; i++)
+        hist_index_add(h, i);
+    return (0);
+}
+
+/**
+ * hist_index_free - frees the trigram index of a history
+ * @x: the index, or NULL
+ */
+void hist_index_free(hist_index_t *x)
+{
+    size_t i;
+
+    if (!x)
+        return;
+    for (i = 0; i < x->size; i++)
+        free(x->slots[i].seq);
+    free(x->slots);
+    free(x);
+}
+
+/**
+ * hist_candidates - finds the commands holding every trigram of a pattern
+ * @h: the history
+ * @pat: the pattern, at least three bytes long
+ * @out: where to store the indexes of the commands, newest first
+ *
+ * Return: number of commands found
+ */
+static size_t hist_candidates(history_t *h, char *pat, size_t *out)
+{
+    size_t n = _strlen(pat) - 2, k, m = 0, j, *top, *live, lo, hi, mid;
+    hist_post_t **lists = malloc(sizeof(*lists) * n), *p;
+    unsigned char *s = (unsigned char *)pat;
+    unsigned long seq;
+
+    top = malloc(sizeof(*top) * n);
+    live = malloc(sizeof(*live) * n);
+    if (!lists || !top || !live)
+        goto done;
+    for (k = 0; k < n; k++)
+    {
+        p = post_slot(h->index, (unsigned int)s[k] << 16 | s[k + 1] << 8
+                | s[k + 2]);
+        if (!p->key)
+            goto done; /* a trigram no command holds */
+        lists[k] = p;
+        live[k] = p->n - post_live(p, h->first);
+        for (j = k; j && live[j - 1] > live[j]; j--) /* shortest first */
+        {
+            lo = live[j], live[j] = live[j - 1], live[j - 1] = lo;
+            p = lists[j], lists[j] = lists[j - 1], lists[j - 1] = p;
+        }
+    }
+    for (k = 0; k < n; k++)
+        top[k] = lists[k]->n;
+    for (j = lists[0]->n; j-- > 0 && lists[0]->seq[j] >= h->first;)
+    {
+        seq = lists[0]->seq[j];
+        for (k = 1; k < n; k++)
+        {
+            if (lists[k] == lists[0])
+                continue;
+            for (lo = 0, hi = top[k]; lo < hi;) /* last number <= seq */
+            {
+                mid = lo + (hi - lo) / 2;
+                if (lists[k]->seq[mid] <= seq)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            top[k] = lo; /* later numbers are smaller */
+            if (!lo || lists[k]->seq[lo - 1] != seq)
+                break;
+        }
+        if (k == n)
+            out[m++] = seq - h->first;
+    }
+done:
+    free(lists);
+    free(top);
+    free(live);
+    return (m);
+}
+
+/**
+ * hist_search - prints the held commands that contain a pattern
+ * @info: the parameter struct
+ * @pat: the pattern
+ *
+ * Commands equal to the pattern come first, then the others, newest
+ * first within each group. The command line being run is left out. The
+ * index is built on first use unless the shell is interactive, whose
+ * index is built when its history is read.
+ *
+ * Return: number of commands printed, -1 on allocation failure
+ */
+ssize_t hist_search(info_t *info, char *pat)
+{
+    history_t *h = &(info->history);
+    const char *parts[] = {NULL, ": ", NULL, "\n"};
+    size_t *found, n = 0, m = 0, i, count = h->count;
+    int exact;
+
+    if (count && h->pending == h->first + count)
+        count--;
+    found = malloc(sizeof(*found) * (h->count + 1));
+    if (!found)
+        return (-1);
+    if (_strlen(pat) >= 3 && !hist_index_build(h))
+        n = hist_candidates(h, pat, found);
+    else
+        for (i = count; i-- > 0;)
+            found[n++] = i;
+    for (i = 0; i < n; i++)
+        if (found[i] < count && strstr(hist_get(h, found[i]), pat))
+            found[m++] = found[i];
+    for (exact = 1; exact >= 0; exact--)
+        for (i = 0; i < m; i++)
+        {
+            parts[2] = hist_get(h, found[i]);
+            if ((_strcmp((char *)parts[2], pat) == 0) != exact)
+                continue;
+            parts[0] = convert_number(h->first + found[i], 10, 0);
+            stream_writev(STDOUT_FILENO, parts, 4);
+        }
+    free(found);
+    return (m);
+}
@@ -0,0 +1,200 @@
+#include "shell.h"
+#include <time.h>
+
+/**
+ * hist_first_since - finds where the commands started since a time begin
+ * @h: the history
+ * @since: the time, in microseconds since the epoch
+ *
+ * The commands are held in the order they were read or appended, which is
+ * not quite the order they started in, but their latest starts only grow,
+ * so a binary search over them skips every command that started before.
+ *
+ * Return: index of the first command that may have started since then
+ */
+static size_t hist_first_since(history_t *h, long long since)
+{
+    size_t lo = 0, hi = h->count, mid;
+
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (hist_meta(h, mid)->latest < since)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo);
+}
+
+/**
+ * hist_digits - writes a number in decimal
+ * @buf: where to write it, room for 21 digits and a NUL
+ * @n: the number
+ * @width: least number of digits, padded with zeros
+ *
+ * Return: the end of what was written
+ */
+static char *hist_digits(char *buf, unsigned long long n, int width)
+{
+    char tmp[24];
+    int i = 0;
+
+    do {
+        tmp[i++] = '0' + n % 10;
+        n /= 10;
+    } while (n || i < width);
+    while (i)
+        *buf++ = tmp[--i];
+    *buf = 0;
+    return (buf);
+}
+
+/**
+ * hist_usec - formats a duration as seconds with three decimals
+ * @buf: where to write it
+ * @us: the duration in microseconds, negative if unknown
+ *
+ * Return: buf
+ */
+static char *hist_usec(char *buf, long long us)
+{
+    char *p;
+
+    if (us < 0)
+        return (_strcpy(buf, "-"));
+    p = hist_digits(buf, us / 1000000, 1);
+    *p++ = '.';
+    p = hist_digits(p, us / 1000 % 1000, 3);
+    _strcpy(p, "s");
+    return (buf);
+}
+
+/**
+ * hist_date - formats a time of day as local date and time
+ * @buf: where to write it, room for 20 bytes
+ * @us: the time in microseconds since the epoch, 0 if unknown
+ *
+ * Return: buf
+ */
+static char *hist_date(char *buf, long long us)
+{
+    time_t t = us / 1000000;
+    struct tm tm, *ok;
+
+#ifndef WINDOWS
+    ok = localtime_r(&t, &tm);
+#else
+    ok = localtime_s(&tm, &t) ? NULL : &tm;
+#endif
+    if (!us || !ok || !strftime(buf, 20, "%Y-%m-%d %H:%M:%S", &tm))
+        _strcpy(buf, "-");
+    return (buf);
+}
+
+/**
+ * hist_show - prints a command with its time, durations, status and cwd
+ * @h: the history
+ * @i: index of the command
+ */
+static void hist_show(history_t *h, size_t i)
+{
+    char num[24], date[20], wall[32], cpu[32], status[24];
+    const char *cmd = hist_get(h, i);
+    hist_meta_t *m = hist_meta(h, i);
+    const char *head[] = {num, "  ", date, "  ", wall, "  ", cpu, "  "};
+    const char *tail[] = {status, "  ", NULL, "  ", cmd, "\n"};
+
+    hist_digits(num, h->first + i, 1);
+    hist_date(date, m->start);
+    hist_usec(wall, m->wall);
+    hist_usec(cpu, m->cpu);
+    if (m->status < 0)
+        _strcpy(status, "-");
+    else
+        hist_digits(status, m->status, 1);
+    tail[2] = cmd + _strlen((char *)cmd) + 1;
+    if (!*tail[2])
+        tail[2] = "-";
+    stream_writev(STDOUT_FILENO, head, 8);
+    stream_writev(STDOUT_FILENO, tail, 6);
+}
+
+/**
+ * hist_sift - restores the order of a min-heap of commands by wall time
+ * @h: the history
+ * @heap: indexes of the commands
+ * @n: number of commands in the heap
+ * @i: the position that may be out of order, toward the leaves
+ */
+static void hist_sift(history_t *h, size_t *heap, size_t n, size_t i)
+{
+    size_t c, t;
+
+    while ((c = 2 * i + 1) < n)
+    {
+        if (c + 1 < n && hist_meta(h, heap[c + 1])->wall
+                < hist_meta(h, heap[c])->wall)
+            c++;
+        if (hist_meta(h, heap[i])->wall <= hist_meta(h, heap[c])->wall)
+            break;
+        t = heap[i], heap[i] = heap[c], heap[c] = t;
+        i = c;
+    }
+}
+
+/**
+ * hist_query - prints the held commands that match a query
+ * @info: the parameter struct
+ * @since: least start time wanted, in microseconds, 0 for any
+ * @failed: on to print only commands that exited with a non-zero status
+ * @slowest: if not 0, print only this many of the longest running ones,
+ *           longest first
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+int hist_query(info_t *info, long long since, int failed, size_t slowest)
+{
+    history_t *h = &(info->history);
+    size_t i = since ? hist_first_since(h, since) : 0, n = 0, k, t;
+    size_t *heap = NULL;
+    hist_meta_t *m;
+
+    if (slowest)
+    {
+        heap = malloc(sizeof(*heap) * (slowest < h->count
+                    ? slowest : h->count + 1));
+        if (!heap)
+            return (-1);
+    }
+    for (; i < h->count; i++)
+    {
+        m = hist_meta(h, i);
+        if (m->start < since || (failed && m->status <= 0))
+            continue;
+        if (!slowest)
+            hist_show(h, i);
+        else if (m->wall < 0)
+            continue;
+        else if (n < slowest)
+        {
+            for (heap[n] = i, k = n++; k && hist_meta(h, heap[(k - 1) / 2])
+                    ->wall > m->wall; k = (k - 1) / 2)
+                t = heap[k], heap[k] = heap[(k - 1) / 2], heap[(k - 1) / 2] = t;
+        }
+        else if (m->wall > hist_meta(h, heap[0])->wall)
+        {
+            heap[0] = i;
+            hist_sift(h, heap, n, 0);
+        }
+    }
+    for (k = n; k > 1; k--) /* sort the heap, longest first */
+    {
+        t = heap[0], heap[0] = heap[k - 1], heap[k - 1] = t;
+        hist_sift(h, heap, k - 1, 0);
+    }
+    for (k = 0; k < n; k++)
+        hist_show(h, heap[k]);
+    free(heap);
+    return (0);
+}
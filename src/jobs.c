@@ -0,0 +1,504 @@
+#include "shell.h"
+
+#ifndef WINDOWS
+#include <signal.h>
+#include <sys/resource.h>
+
+/* set by the SIGCHLD handler, cleared once the job table is reaped */
+static volatile sig_atomic_t child_exited;
+/* CPU time of every child reaped so far, in microseconds */
+static long long reaped_cpu;
+
+/**
+ * wait_child - waits for a child as waitpid() does
+ * @pid: the child, or -1 for any
+ * @ws: where to store the wait status
+ * @options: as for waitpid()
+ *
+ * The CPU time of a child that ended is added to children_cpu(), which
+ * so costs no system call of its own.
+ *
+ * Return: as waitpid()
+ */
+pid_t wait_child(pid_t pid, int *ws, int options)
+{
+    struct rusage ru;
+    pid_t r = wait4(pid, ws, options, &ru);
+
+    if (r > 0 && (WIFEXITED(*ws) || WIFSIGNALED(*ws)))
+        reaped_cpu += (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000LL
+            + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+    return (r);
+}
+
+/**
+ * children_cpu - gets the CPU time of the children reaped so far
+ *
+ * Return: the time in microseconds
+ */
+long long children_cpu(void)
+{
+    return (reaped_cpu);
+}
+
+/**
+ * sigchld_handler - notes that a child changed state
+ * @sig_num: the signal number
+ */
+static void sigchld_handler(int sig_num)
+{
+    (void)sig_num;
+    child_exited = 1;
+}
+
+/**
+ * job_update - records a wait status reported for one process of a job
+ * @job: the job
+ * @i: index of the process in the job
+ * @ws: the status reported by waitpid()
+ */
+static void job_update(job_t *job, int i, int ws)
+{
+    if (WIFSTOPPED(ws))
+    {
+        job->state = JOB_STOPPED;
+        job->notified = 0;
+        return;
+    }
+    if (WIFCONTINUED(ws))
+    {
+        job->state = JOB_RUNNING;
+        return;
+    }
+    job->status[i] = exit_status(ws);
+    if (--job->nlive == 0)
+    {
+        job->state = JOB_DONE;
+        job->exit = job->status[job->nprocs - 1];
+        job->notified = 0;
+    }
+}
+
+/**
+ * job_add - adds a background job to the job table
+ * @info: the parameter struct
+ * @pids: the pids of the job's processes, last stage last
+ * @n: number of processes
+ * @pgid: process group of the job
+ * @cmd: malloc'd command line of the job, owned by the table afterwards
+ *
+ * Return: the job, or NULL on allocation failure
+ */
+job_t *job_add(info_t *info, pid_t *pids, int n, pid_t pgid, char *cmd)
+{
+    struct sigaction sa;
+    job_t *job, **tail;
+    int i, id = 1;
+
+    for (tail = &info->jobs; *tail; tail = &(*tail)->next)
+        id = (*tail)->id + 1;
+    job = malloc(sizeof(*job));
+    if (!job)
+        return (free(cmd), NULL);
+    job->pids = malloc(sizeof(pid_t) * n);
+    job->status = malloc(sizeof(int) * n);
+    if (!job->pids || !job->status)
+        return (free(job->pids), free(job->status), free(job), free(cmd), NULL);
+    for (i = 0; i < n; i++)
+    {
+        job->pids[i] = pids[i];
+        job->status[i] = -1;
+    }
+    job->id = id;
+    job->pgid = pgid;
+    job->nprocs = job->nlive = n;
+    job->state = JOB_RUNNING;
+    job->exit = 0;
+    job->notified = 1;
+    job->cmd = cmd;
+    job->next = NULL;
+    *tail = job;
+    if (!info->sigchld_set)
+    {
+        sa.sa_handler = sigchld_handler;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_flags = SA_RESTART;
+        sigaction(SIGCHLD, &sa, NULL);
+        info->sigchld_set = 1;
+    }
+    return (job);
+}
+
+/**
+ * job_find - finds a job from a job spec
+ * @info: the parameter struct
+ * @spec: %N or N for a job id, %% or %+ or NULL for the current job
+ *
+ * Return: the job, or NULL if there is no such job
+ */
+job_t *job_find(info_t *info, char *spec)
+{
+    job_t *job, *last = NULL;
+    int id;
+
+    for (job = info->jobs; job; job = job->next)
+        last = job;
+    if (!spec || !_strcmp(spec, "%%") || !_strcmp(spec, "%+"))
+        return (last);
+    if (*spec == '%')
+        spec++;
+    id = _erratoi(spec);
+    for (job = info->jobs; job && id > 0; job = job->next)
+        if (job->id == id)
+            return (job);
+    return (NULL);
+}
+
+/**
+ * job_remove - removes a job from the table and frees it
+ * @info: the parameter struct
+ * @job: the job
+ */
+void job_remove(info_t *info, job_t *job)
+{
+    job_t **p;
+
+    for (p = &info->jobs; *p; p = &(*p)->next)
+        if (*p == job)
+        {
+            *p = job->next;
+            free(job->pids);
+            free(job->status);
+            free(job->cmd);
+            free(job);
+            return;
+        }
+}
+
+/**
+ * jobs_reap - collects finished background processes without blocking
+ * @info: the parameter struct
+ */
+void jobs_reap(info_t *info)
+{
+    job_t *job;
+    int i, ws;
+
+    if (!child_exited)
+        return;
+    child_exited = 0;
+    for (job = info->jobs; job; job = job->next)
+        for (i = 0; i < job->nprocs; i++)
+            if (job->status[i] == -1 && wait_child(job->pids[i], &ws,
+                        WNOHANG | WUNTRACED | WCONTINUED) > 0)
+                job_update(job, i, ws);
+}
+
+/**
+ * job_print - prints one line of the job table
+ * @job: the job
+ * @current: 1 if this is the current job
+ * @pids: 1 to print the process group as well
+ */
+static void job_print(job_t *job, int current, int pids)
+{
+    char *state = "Running";
+    int i;
+
+    if (job->state == JOB_STOPPED)
+        state = "Stopped";
+    else if (job->state == JOB_DONE)
+        state = job->exit ? "Exit " : "Done";
+    _putchar('[');
+    _puts(convert_number(job->id, 10, 0));
+    _putchar(']');
+    _putchar(current ? '+' : ' ');
+    _puts("  ");
+    if (pids)
+    {
+        _puts(convert_number(job->pgid, 10, 0));
+        _putchar(' ');
+    }
+    _puts(state);
+    i = _strlen(state);
+    if (job->state == JOB_DONE && job->exit)
+    {
+        _puts(convert_number(job->exit, 10, 0));
+        i += _strlen(convert_number(job->exit, 10, 0));
+    }
+    for (; i < 24; i++)
+        _putchar(' ');
+    _puts(job->cmd);
+    if (job->state == JOB_RUNNING)
+        _puts(" &");
+    _putchar('\n');
+}
+
+/**
+ * jobs_notify - reports jobs that finished or stopped since the last prompt
+ * @info: the parameter struct
+ *
+ * Finished jobs are forgotten once reported. When the shell is not
+ * interactive nothing is printed and finished jobs are kept for wait.
+ */
+void jobs_notify(info_t *info)
+{
+    job_t *job, *next;
+
+    if (!interactive(info))
+        return;
+    for (job = info->jobs; job; job = next)
+    {
+        next = job->next;
+        if (!job->notified)
+        {
+            job_print(job, !next, 0);
+            job->notified = 1;
+        }
+        if (job->state == JOB_DONE)
+            job_remove(info, job);
+    }
+}
+
+/**
+ * job_wait - waits for a job to finish or stop
+ * @info: the parameter struct
+ * @job: the job
+ *
+ * Return: the exit status of the job, or 128 plus the stop signal
+ */
+int job_wait(info_t *info, job_t *job)
+{
+    int i, ws;
+
+    (void)info;
+    for (i = 0; i < job->nprocs && job->state != JOB_STOPPED; i++)
+    {
+        if (job->status[i] != -1)
+            continue;
+        while (wait_child(job->pids[i], &ws, WUNTRACED) == -1)
+            if (errno != EINTR)
+            {
+                ws = 0;
+                break;
+            }
+        job_update(job, i, ws);
+        if (WIFSTOPPED(ws))
+            return (128 + WSTOPSIG(ws));
+    }
+    return (job->exit);
+}
+
+/**
+ * jobs_free - forgets every job
+ * @info: the parameter struct
+ */
+void jobs_free(info_t *info)
+{
+    while (info->jobs)
+        job_remove(info, info->jobs);
+}
+
+/**
+ * _myjobs - lists the background jobs
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *  Return: Always 0
+ */
+int _myjobs(info_t *info)
+{
+    job_t *job, *next;
+    int pids = info->argv[1] && !_strcmp(info->argv[1], "-l");
+
+    jobs_reap(info);
+    for (job = info->jobs; job; job = next)
+    {
+        next = job->next;
+        job_print(job, !next, pids);
+        job->notified = 1;
+        if (job->state == JOB_DONE)
+            job_remove(info, job);
+    }
+    return (0);
+}
+
+/**
+ * wait_any - waits until any background job finishes
+ * @info: the parameter struct
+ *
+ * Return: the exit status of that job, or 127 if there are no jobs
+ */
+static int wait_any(info_t *info)
+{
+    job_t *job;
+    pid_t pid;
+    int i, ws, status;
+
+    for (job = info->jobs; job; job = job->next)
+        if (job->state == JOB_DONE)
+        {
+            status = job->exit;
+            job_remove(info, job);
+            return (status);
+        }
+    while (info->jobs)
+    {
+        pid = wait_child(-1, &ws, 0);
+        if (pid == -1 && errno == EINTR)
+            continue;
+        if (pid == -1)
+            break;
+        for (job = info->jobs; job; job = job->next)
+            for (i = 0; i < job->nprocs; i++)
+                if (job->pids[i] == pid && job->status[i] == -1)
+                {
+                    job_update(job, i, ws);
+                    if (job->state == JOB_DONE)
+                    {
+                        status = job->exit;
+                        job_remove(info, job);
+                        return (status);
+                    }
+                }
+    }
+    return (127);
+}
+
+/**
+ * _mywait - waits for background jobs
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *
+ * With no arguments waits for every job, -n waits for the next job to
+ * finish, %N waits for job N and a plain number waits for that pid.
+ *
+ *  Return: the exit status of the last job waited for
+ */
+int _mywait(info_t *info)
+{
+    job_t *job, *next;
+    int i, k, status = 0;
+
+    jobs_reap(info);
+    if (info->argc == 1)
+    {
+        for (job = info->jobs; job; job = next)
+        {
+            next = job->next;
+            job_wait(info, job);
+            if (job->state == JOB_DONE)
+                job_remove(info, job);
+        }
+        return (info->status = 0);
+    }
+    if (!_strcmp(info->argv[1], "-n"))
+        return (info->status = wait_any(info));
+    for (i = 1; info->argv[i]; i++)
+    {
+        job = NULL;
+        if (info->argv[i][0] == '%')
+            job = job_find(info, info->argv[i]);
+        else
+            for (job = info->jobs; job; job = job->next)
+            {
+                for (k = 0; k < job->nprocs; k++)
+                    if (job->pids[k] == _atoi(info->argv[i]))
+                        break;
+                if (k < job->nprocs)
+                    break;
+            }
+        if (!job)
+        {
+            status = 127;
+            continue;
+        }
+        status = job_wait(info, job);
+        if (job->state == JOB_DONE)
+            job_remove(info, job);
+    }
+    return (info->status = status);
+}
+
+/**
+ * job_continue - resumes a stopped job
+ * @job: the job
+ */
+static void job_continue(job_t *job)
+{
+    int i;
+
+    if (job->pgid > 0)
+        kill(-job->pgid, SIGCONT);
+    else
+        for (i = 0; i < job->nprocs; i++)
+            if (job->status[i] == -1)
+                kill(job->pids[i], SIGCONT);
+    job->state = JOB_RUNNING;
+}
+
+/**
+ * _myfg - moves a job to the foreground
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *  Return: the exit status of the job
+ */
+int _myfg(info_t *info)
+{
+    job_t *job = job_find(info, info->argv[1]);
+    sigset_t set, old;
+    int status, tty = interactive(info) && job && job->pgid > 0;
+
+    if (!job)
+    {
+        print_error(info, "no such job\n");
+        return (info->status = 1);
+    }
+    _puts(job->cmd);
+    _putchar('\n');
+    _putchar(BUF_FLUSH);
+    if (tty)
+        tcsetpgrp(STDIN_FILENO, job->pgid);
+    job_continue(job);
+    status = job_wait(info, job);
+    if (tty)
+    {
+        sigemptyset(&set);
+        sigaddset(&set, SIGTTOU);
+        sigprocmask(SIG_BLOCK, &set, &old);
+        tcsetpgrp(STDIN_FILENO, getpgrp());
+        sigprocmask(SIG_SETMASK, &old, NULL);
+    }
+    if (job->state == JOB_STOPPED)
+    {
+        job->notified = 1;
+        job_print(job, 1, 0);
+    }
+    else
+        job_remove(info, job);
+    return (info->status = status);
+}
+
+/**
+ * _mybg - resumes a stopped job in the background
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *  Return: 0 on success, 1 if there is no such job
+ */
+int _mybg(info_t *info)
+{
+    job_t *job = job_find(info, info->argv[1]);
+
+    if (!job)
+    {
+        print_error(info, "no such job\n");
+        return (info->status = 1);
+    }
+    job_continue(job);
+    _putchar('[');
+    _puts(convert_number(job->id, 10, 0));
+    _puts("]+ ");
+    _puts(job->cmd);
+    _puts(" &\n");
+    return (info->status = 0);
+}
+#endif
@@ -0,0 +1,305 @@
+#include "shell.h"
+
+/**
+ * is_op_char - checks whether a character ends a word
+ * @c: the character
+ *
+ * Return: 1 if c is a blank or starts an operator, 0 otherwise
+ */
+static int is_op_char(char c)
+{
+    return (c == ' ' || c == '\t' || c == '\n' || c == ';' || c == '&'
+            || c == '|' || c == '<' || c == '>' || c == '(' || c == ')');
+}
+
+/**
+ * tok_push - appends a token to a token array
+ * @tl: the token array
+ * @off: offset of the token
+ * @len: length of the token
+ * @kind: kind of the token
+ * @flags: flags of the token
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int tok_push(tokens_t *tl, size_t off, size_t len, int kind, int flags)
+{
+    token_t *v;
+    size_t cap;
+
+    if (tl->n == tl->cap)
+    {
+        cap = tl->cap ? tl->cap * 2 : 16;
+        v = realloc(tl->v, sizeof(token_t) * cap);
+        if (!v)
+            return (-1);
+        tl->v = v;
+        tl->cap = cap;
+    }
+    tl->v[tl->n].off = off;
+    tl->v[tl->n].len = len;
+    tl->v[tl->n].kind = kind;
+    tl->v[tl->n].flags = flags;
+    tl->n++;
+    return (0);
+}
+
+/**
+ * lex_word - finds the end of a word
+ * @s: the line
+ * @i: offset of the first character of the word
+ * @flags: address to store the TOKF_ flags of the word in
+ *
+ * Return: offset one past the word, or 0 if a quote is not closed
+ */
+static size_t lex_word(char *s, size_t i, int *flags)
+{
+    *flags = 0;
+    while (s[i] && !is_op_char(s[i]))
+    {
+        if (s[i] == '\\')
+        {
+            *flags |= TOKF_QUOTED;
+            i += s[i + 1] ? 2 : 1;
+        }
+        else if (s[i] == '\'')
+        {
+            *flags |= TOKF_QUOTED;
+            for (i++; s[i] && s[i] != '\''; i++)
+                ;
+            if (!s[i++])
+                return (0);
+        }
+        else if (s[i] == '"')
+        {
+            *flags |= TOKF_QUOTED;
+            for (i++; s[i] && s[i] != '"'; i++)
+                if (s[i] == '\\' && s[i + 1])
+                    i++;
+                else if (s[i] == '$')
+                    *flags |= TOKF_DOLLAR;
+            if (!s[i++])
+                return (0);
+        }
+        else
+        {
+            if (s[i] == '$')
+                *flags |= TOKF_DOLLAR;
+            i++;
+        }
+    }
+    return (i);
+}
+
+/**
+ * lex - splits a command line into tokens in a single pass
+ * @s: the line, NUL terminated
+ * @tl: the token array to fill, emptied first
+ *
+ * Tokens are spans over s; nothing is copied. A '#' at the start of a
+ * token begins a comment and newlines separate commands like ';'.
+ *
+ * Return: 0 on success, -1 if a quote is not closed, -2 if out of memory
+ */
+int lex(char *s, tokens_t *tl)
+{
+    size_t i = 0, start;
+    int kind, flags;
+
+    tl->n = 0;
+    while (1)
+    {
+        while (s[i] == ' ' || s[i] == '\t')
+            i++;
+        if (!s[i] || s[i] == '#')
+            return (0);
+        start = i;
+        flags = 0;
+        kind = TOK_WORD;
+        if (s[i] == ';' && s[i + 1] == ';')
+            kind = TOK_DSEMI, i += 2;
+        else if (s[i] == ';' || s[i] == '\n')
+            kind = TOK_SEMI, i++;
+        else if (s[i] == '&')
+            kind = s[i + 1] == '&' ? (i += 2, TOK_AND) : (i++, TOK_BG);
+        else if (s[i] == '|')
+            kind = s[i + 1] == '|' ? (i += 2, TOK_OR) : (i++, TOK_PIPE);
+        else if (s[i] == '<')
+            kind = TOK_LESS, i++;
+        else if (s[i] == '>')
+            kind = s[i + 1] == '>' ? (i += 2, TOK_DGREAT) : (i++, TOK_GREAT);
+        else if (s[i] == '(' || s[i] == ')')
+            kind = s[i] == '(' ? TOK_LPAREN : TOK_RPAREN, i++;
+        else
+        {
+            i = lex_word(s, i, &flags);
+            if (!i)
+                return (-1);
+        }
+        if (tok_push(tl, start, i - start, kind, flags) == -1)
+            return (-2);
+    }
+}
+
+/**
+ * var_name - measures the name after a '$'
+ * @s: the text after the '$'
+ * @len: number of bytes available
+ *
+ * Return: length of ?, $, !, NAME or {NAME}, or 0 if no name follows
+ */
+static size_t var_name(const char *s, size_t len)
+{
+    size_t k = 1;
+
+    if (!len)
+        return (0);
+    if (*s == '?' || *s == '$' || *s == '!')
+        return (1);
+    if (*s == '{')
+    {
+        k = var_name(s + 1, len - 1);
+        return (k && s[1] != '{' && k + 1 < len && s[k + 1] == '}'
+                ? k + 2 : 0);
+    }
+    if (!_isalpha(*s) && *s != '_')
+        return (0);
+    while (k < len && (_isalpha(s[k]) || (s[k] >= '0' && s[k] <= '9')
+                || s[k] == '_'))
+        k++;
+    return (k);
+}
+
+/**
+ * word_copy - removes quotes and expands variables of a word
+ * @info: the parameter struct
+ * @s: the word as written
+ * @len: length of the word
+ * @out: buffer to write the result to, or NULL to only measure it
+ *
+ * out may be s itself when the word has no '$', since removing quotes
+ * never makes a word longer.
+ *
+ * Return: length of the result
+ */
+static size_t word_copy(info_t *info, char *s, size_t len, char *out)
+{
+    size_t i = 0, n = 0, k;
+    int dq = 0, brace;
+    const char *v;
+
+    while (i < len)
+    {
+        if (s[i] == '\'' && !dq)
+        {
+            for (i++; s[i] != '\''; i++, n++)
+                if (out)
+                    out[n] = s[i];
+            i++;
+        }
+        else if (s[i] == '"')
+            dq = !dq, i++;
+        else if (s[i] == '\\' && i + 1 < len
+                && (!dq || _strchr("$`\"\\", s[i + 1])))
+        {
+            if (out)
+                out[n] = s[i + 1];
+            n++, i += 2;
+        }
+        else if (s[i] == '$' && (k = var_name(s + i + 1, len - i - 1)))
+        {
+            brace = s[i + 1] == '{';
+            v = var_value(info, s + i + 1 + brace, k - 2 * brace);
+            for (; v && *v; v++, n++)
+                if (out)
+                    out[n] = *v;
+            i += 1 + k;
+        }
+        else
+        {
+            if (out)
+                out[n] = s[i];
+            n++, i++;
+        }
+    }
+    return (n);
+}
+
+/**
+ * tok_word - returns the text of a token as a NUL terminated string
+ * @info: the parameter struct
+ * @base: the line the token refers to
+ * @t: the token
+ *
+ * Plain words are terminated in place and quoted words are unescaped in
+ * place; only words with a '$' are copied, into info->arena. Operators
+ * are returned as written. Either way the line itself is modified, and
+ * an unescaped token is marked TOKF_DONE so it can be read again, as the
+ * commands of a loop are.
+ *
+ * Return: the string, or NULL on allocation failure
+ */
+char *tok_word(info_t *info, char *base, token_t *t)
+{
+    char *s = base + t->off, *out;
+    size_t n;
+
+    if (t->kind != TOK_WORD || !t->flags || t->flags & TOKF_DONE)
+    {
+        s[t->len] = 0;
+        return (s);
+    }
+    if (!(t->flags & TOKF_DOLLAR))
+    {
+        n = word_copy(info, s, t->len, s);
+        s[n] = 0;
+        t->len = n;
+        t->flags |= TOKF_DONE;
+        return (s);
+    }
+    n = word_copy(info, s, t->len, NULL);
+    out = arena_alloc(&(info->arena), n + 1);
+    if (!out)
+        return (NULL);
+    word_copy(info, s, t->len, out);
+    out[n] = 0;
+    return (out);
+}
+
+/**
+ * syntax_error - reports a syntax error in the current line
+ * @info: the parameter struct
+ * @what: description of the error
+ */
+void syntax_error(info_t *info, char *what)
+{
+    if (info->linecount_flag == 1)
+    {
+        info->line_count++;
+        info->linecount_flag = 0;
+    }
+    info->status = 2;
+    _eputs(info->fname);
+    _eputs(": ");
+    print_d(info->line_count, STDERR_FILENO);
+    _eputs(": Syntax error: ");
+    _eputs(what);
+    _eputchar('\n');
+}
+
+/**
+ * tok_unexpected - describes an unexpected token for syntax_error()
+ * @t: the token, or NULL for the end of the line
+ *
+ * Return: the description
+ */
+char *tok_unexpected(token_t *t)
+{
+    static char *msg[] = {"word unexpected", "\";\" unexpected",
+        "\"&&\" unexpected", "\"||\" unexpected", "\"|\" unexpected",
+        "\"&\" unexpected", "\"<\" unexpected", "\">\" unexpected",
+        "\">>\" unexpected", "\";;\" unexpected", "\"(\" unexpected",
+        "\")\" unexpected"};
+
+    return (t ? msg[t->kind] : "newline unexpected");
+}
@@ -0,0 +1,445 @@
+#define _GNU_SOURCE /* for pipe2() */
+#include "shell.h"
+
+#ifndef WINDOWS
+#include <poll.h>
+
+#define PAR_FREE 0
+#define PAR_RUNNING 1
+#define PAR_DONE 2
+
+/**
+ * struct par_buf - growable byte buffer holding a job's captured output
+ * @data: the bytes
+ * @len: number of bytes used
+ * @cap: number of bytes allocated
+ */
+typedef struct par_buf
+{
+    char *data;
+    size_t len;
+    size_t cap;
+} par_buf_t;
+
+/**
+ * struct par_slot - one job of the parallel executor
+ * @state: PAR_FREE, PAR_RUNNING or PAR_DONE
+ * @seq: input line number of the job
+ * @pid: pid of the job
+ * @fd: read ends of the job's stdout and stderr pipes, -1 once closed
+ * @out: captured stdout and stderr
+ * @status: exit status of the job
+ */
+typedef struct par_slot
+{
+    int state;
+    unsigned long seq;
+    pid_t pid;
+    int fd[2];
+    par_buf_t out[2];
+    int status;
+} par_slot_t;
+
+/**
+ * struct par_reader - buffered reader for the argument lines
+ * @fd: the descriptor to read from
+ * @buf: bytes read but not yet consumed
+ * @start: offset of the first unconsumed byte
+ * @len: number of bytes in buf
+ * @eof: on once read() returned 0
+ */
+typedef struct par_reader
+{
+    int fd;
+    char buf[READ_BUF_SIZE];
+    size_t start;
+    size_t len;
+    int eof;
+} par_reader_t;
+
+/**
+ * buf_append - appends bytes to a par_buf
+ * @b: the buffer
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int buf_append(par_buf_t *b, char *s, size_t n)
+{
+    char *p;
+    size_t cap;
+
+    if (b->len + n + 1 > b->cap)
+    {
+        for (cap = b->cap ? b->cap : 256; cap < b->len + n + 1; cap *= 2)
+            ;
+        p = realloc(b->data, cap);
+        if (!p)
+            return (-1);
+        b->data = p;
+        b->cap = cap;
+    }
+    memcpy(b->data + b->len, s, n);
+    b->len += n;
+    b->data[b->len] = 0;
+    return (0);
+}
+
+/**
+ * write_all - writes a whole buffer to a descriptor
+ * @fd: the descriptor
+ * @s: the bytes
+ * @n: number of bytes
+ */
+static void write_all(int fd, char *s, size_t n)
+{
+    ssize_t w;
+
+    while (n)
+    {
+        w = write(fd, s, n);
+        if (w == -1 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return;
+        s += w;
+        n -= w;
+    }
+}
+
+/**
+ * next_line - reads the next argument line
+ * @r: the reader
+ *
+ * Return: malloc'd line without its newline, or NULL at end of input
+ */
+static char *next_line(par_reader_t *r)
+{
+    par_buf_t line = {NULL, 0, 0};
+    char *nl;
+    ssize_t n;
+    size_t k;
+
+    while (1)
+    {
+        if (r->start == r->len && !r->eof)
+        {
+            n = read(r->fd, r->buf, sizeof(r->buf));
+            if (n == -1 && errno == EINTR)
+                continue;
+            r->start = 0;
+            r->len = n > 0 ? n : 0;
+            r->eof = n <= 0;
+        }
+        if (r->start == r->len)
+            return (line.data ? line.data : NULL);
+        nl = memchr(r->buf + r->start, '\n', r->len - r->start);
+        k = nl ? (size_t)(nl - r->buf) - r->start : r->len - r->start;
+        if (buf_append(&line, r->buf + r->start, k) == -1)
+            return (free(line.data), NULL);
+        r->start += k + (nl != NULL);
+        if (nl)
+            return (line.data ? line.data : shell_strdup(""));
+    }
+}
+
+/**
+ * build_argv - instantiates the command template for one input line
+ * @tmpl: the command template, NULL terminated
+ * @arg: the input line
+ *
+ * Every {} in the template is replaced by the line. If there is no {},
+ * the line is appended as the last argument.
+ *
+ * Return: malloc'd argument vector, or NULL on allocation failure
+ */
+static char **build_argv(char **tmpl, char *arg)
+{
+    char **av, *p;
+    int i, n, used = 0;
+    par_buf_t b;
+
+    for (n = 0; tmpl[n]; n++)
+        ;
+    av = malloc(sizeof(char *) * (n + 2));
+    if (!av)
+        return (NULL);
+    for (i = 0; i < n; i++)
+    {
+        b.data = NULL;
+        b.len = b.cap = 0;
+        for (p = tmpl[i]; *p; p++)
+            if (p[0] == '{' && p[1] == '}')
+                buf_append(&b, arg, _strlen(arg)), p++, used = 1;
+            else
+                buf_append(&b, p, 1);
+        av[i] = b.data ? b.data : shell_strdup("");
+        if (!av[i])
+            return (av[i] = NULL, ffree(av), NULL);
+    }
+    av[n] = used ? NULL : shell_strdup(arg);
+    av[n + 1] = NULL;
+    return (av);
+}
+
+/**
+ * start_job - starts one job in a free slot
+ * @info: the parameter struct
+ * @slot: the slot
+ * @tmpl: the command template
+ * @arg: the input line
+ * @devnull: descriptor of /dev/null, used as the job's stdin
+ *
+ * Return: 0 if the job was started, otherwise its exit status
+ */
+static int start_job(info_t *info, par_slot_t *slot, char **tmpl, char *arg,
+        int devnull)
+{
+    char **av = build_argv(tmpl, arg), *path;
+    int out[2] = {-1, -1}, err[2] = {-1, -1}, std[3], ret = 0;
+
+    if (!av)
+        return (1);
+    path = resolve_cmd(info, av[0]);
+    if (!path)
+    {
+        _eputs("parallel: ");
+        _eputs(av[0]);
+        _eputs(": not found\n");
+        return (ffree(av), 127);
+    }
+    if (pipe2(out, O_CLOEXEC) == -1 || pipe2(err, O_CLOEXEC) == -1)
+        ret = 1;
+    std[0] = devnull;
+    std[1] = out[1];
+    std[2] = err[1];
+    if (!ret && spawn_cmd(info, path, av, std, -1, &slot->pid))
+        ret = 126;
+    if (out[1] != -1)
+        close(out[1]);
+    if (err[1] != -1)
+        close(err[1]);
+    ffree(av);
+    if (ret)
+    {
+        if (out[0] != -1)
+            close(out[0]);
+        if (err[0] != -1)
+            close(err[0]);
+        return (ret);
+    }
+    slot->fd[0] = out[0];
+    slot->fd[1] = err[0];
+    slot->out[0].len = slot->out[1].len = 0;
+    slot->state = PAR_RUNNING;
+    return (0);
+}
+
+/**
+ * flush_slot - writes a finished job's output and frees its slot
+ * @slot: the slot
+ */
+static void flush_slot(par_slot_t *slot)
+{
+    write_all(STDOUT_FILENO, slot->out[0].data, slot->out[0].len);
+    write_all(STDERR_FILENO, slot->out[1].data, slot->out[1].len);
+    slot->state = PAR_FREE;
+}
+
+/**
+ * collect - reads output from running jobs and reaps finished ones
+ * @slots: the slots
+ * @n: number of slots
+ *
+ * Blocks until at least one job has produced output or finished.
+ *
+ * Return: number of jobs that finished
+ */
+static int collect(par_slot_t *slots, int n)
+{
+    struct pollfd *pfd;
+    int i, j, k = 0, done = 0, ws;
+    char buf[4096];
+    ssize_t r;
+
+    pfd = malloc(sizeof(*pfd) * n * 2);
+    if (!pfd)
+        return (0);
+    for (i = 0; i < n; i++)
+        for (j = 0; slots[i].state == PAR_RUNNING && j < 2; j++)
+            if (slots[i].fd[j] != -1)
+            {
+                pfd[k].fd = slots[i].fd[j];
+                pfd[k++].events = POLLIN;
+            }
+    if (k && poll(pfd, k, -1) == -1)
+        while (k--)
+            pfd[k].revents = 0;
+    for (i = 0; i < n; i++)
+    {
+        for (j = 0; slots[i].state == PAR_RUNNING && j < 2; j++)
+        {
+            if (slots[i].fd[j] == -1)
+                continue;
+            for (k = 0; pfd[k].fd != slots[i].fd[j]; k++)
+                ;
+            if (!pfd[k].revents)
+                continue;
+            r = read(slots[i].fd[j], buf, sizeof(buf));
+            if (r > 0)
+                buf_append(&slots[i].out[j], buf, r);
+            else if (r == 0 || errno != EINTR)
+                close(slots[i].fd[j]), slots[i].fd[j] = -1;
+        }
+        if (slots[i].state == PAR_RUNNING && slots[i].fd[0] == -1
+                && slots[i].fd[1] == -1)
+        {
+            while (wait_child(slots[i].pid, &ws, 0) == -1 && errno == EINTR)
+                ;
+            slots[i].status = exit_status(ws);
+            slots[i].state = PAR_DONE;
+            done++;
+        }
+    }
+    free(pfd);
+    return (done);
+}
+
+/**
+ * parse_opts - parses the options of the parallel builtin
+ * @info: the parameter struct
+ * @jobs: address to store the number of job slots in
+ * @keep: address to store the --keep-order flag in
+ * @file: address to store the argument file name in
+ *
+ * Return: index of the first word of the command template, or -1
+ */
+static int parse_opts(info_t *info, long *jobs, int *keep, char **file)
+{
+    char **av = info->argv;
+    int i;
+
+    for (i = 1; av[i] && av[i][0] == '-'; i++)
+    {
+        if (!_strcmp(av[i], "-k") || !_strcmp(av[i], "--keep-order"))
+            *keep = 1;
+        else if ((!_strcmp(av[i], "-j") || !_strcmp(av[i], "--jobs"))
+                && av[i + 1])
+            *jobs = _erratoi(av[++i]);
+        else if (starts_with(av[i], "-j") && av[i][2])
+            *jobs = _erratoi(av[i] + 2);
+        else if ((!_strcmp(av[i], "-a") || !_strcmp(av[i], "--arg-file"))
+                && av[i + 1])
+            *file = av[++i];
+        else if (!_strcmp(av[i], "--"))
+            return (av[i + 1] ? i + 1 : -1);
+        else
+            return (-1);
+    }
+    if (*jobs <= 0)
+        return (-1);
+    return (av[i] ? i : -1);
+}
+
+/**
+ * _myparallel - runs a command once per input line on N job slots
+ * @info: Structure containing potential arguments. Used to maintain
+ *        constant function prototype.
+ *
+ * Output of each job is captured and written in one piece when the job
+ * finishes, so lines of different jobs never interleave. With -k the
+ * output is written in input order. At most N jobs run at a time and,
+ * with -k, at most N finished jobs wait for an earlier one.
+ *
+ * Return: number of failed jobs, at most 101
+ */
+int _myparallel(info_t *info)
+{
+    long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int keep = 0, first, nslots, running = 0, failed = 0, i, ret;
+    unsigned long seq = 0, next_out = 0;
+    char *file = NULL, *line;
+    par_reader_t *in;
+    par_slot_t *slots;
+    int devnull;
+
+    if (jobs < 1)
+        jobs = 1;
+    first = parse_opts(info, &jobs, &keep, &file);
+    if (first == -1)
+    {
+        _eputs("Usage: parallel [-j N] [-k] [-a FILE] COMMAND [ARGS...]\n");
+        return (info->status = 255);
+    }
+    nslots = keep ? jobs * 2 : jobs;
+    in = malloc(sizeof(*in));
+    slots = malloc(sizeof(*slots) * nslots);
+    if (!in || !slots)
+        return (free(in), free(slots), info->status = 255);
+    _memset((char *)slots, 0, sizeof(*slots) * nslots);
+    in->fd = file ? open(file, O_RDONLY | O_CLOEXEC) : STDIN_FILENO;
+    in->start = in->len = 0;
+    in->eof = 0;
+    if (in->fd == -1)
+    {
+        print_error(info, "cannot open ");
+        _eputs(file), _eputchar('\n');
+        return (free(in), free(slots), info->status = 255);
+    }
+    devnull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    stream_flush_all();
+    while (1)
+    {
+        for (i = 0; i < nslots && running < jobs && !in->eof; i++)
+        {
+            if (slots[i].state != PAR_FREE)
+                continue;
+            line = next_line(in);
+            if (!line)
+                break;
+            slots[i].seq = seq++;
+            ret = start_job(info, &slots[i], info->argv + first, line, devnull);
+            free(line);
+            if (ret)
+            {
+                slots[i].status = ret;
+                slots[i].state = PAR_DONE;
+                slots[i].out[0].len = slots[i].out[1].len = 0;
+            }
+            else
+                running++;
+        }
+        if (!running && (in->eof || keep))
+        {
+            for (i = 0; i < nslots; i++)
+                if (slots[i].state == PAR_DONE)
+                    break;
+            if (i == nslots && in->eof)
+                break;
+        }
+        if (running)
+            running -= collect(slots, nslots);
+        for (i = 0; i < nslots; i++)
+        {
+            if (slots[i].state != PAR_DONE
+                    || (keep && slots[i].seq != next_out))
+                continue;
+            failed += slots[i].status != 0;
+            flush_slot(&slots[i]);
+            next_out++;
+            if (keep)
+                i = -1;
+        }
+    }
+    if (file)
+        close(in->fd);
+    if (devnull != -1)
+        close(devnull);
+    for (i = 0; i < nslots; i++)
+        free(slots[i].out[0].data), free(slots[i].out[1].data);
+    free(slots);
+    free(in);
+    return (info->status = failed > 101 ? 101 : failed);
+}
+#endif
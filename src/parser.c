@@ -84,3 +84,20 @@ char *find_path(info_t *info, char *pathstr, char *cmd)
 	}
 	return (NULL);
 }
+
+/**
+ * resolve_cmd - finds the program to run for a command name
+ * @info: the info struct
+ * @cmd: the command name
+ *
+ * Return: path of the program, or NULL if it was not found
+ */
+char *resolve_cmd(info_t *info, char *cmd)
+{
+	char *path = hash_find_path(info, cmd);
+
+	if (!path && (interactive(info) || _getenv(info, "PATH=")
+				|| cmd[0] == '/') && is_cmd(info, cmd))
+		path = cmd;
+	return (path);
+}
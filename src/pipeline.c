@@ -0,0 +1,278 @@
+#define _GNU_SOURCE /* for pipe2() */
+#include "shell.h"
+
+/**
+ * is_pipeline - checks whether the current command contains a '|'
+ * @info: the parameter & return info struct
+ *
+ * Return: 1 if the command is a pipeline, 0 otherwise
+ */
+int is_pipeline(info_t *info)
+{
+#ifdef WINDOWS
+    (void)info;
+    return (0);
+#else
+    size_t i;
+
+    for (i = info->tok_start; i < info->tok_end; i++)
+        if (info->tokens.v[i].kind == TOK_PIPE)
+            return (1);
+    return (0);
+#endif
+}
+
+#ifndef WINDOWS
+/**
+ * split_pipeline - finds the token range of every stage of a pipeline
+ * @info: the parameter & return info struct
+ * @n: address to store the number of stages in
+ *
+ * Return: malloc'd array of the index each stage starts at, plus one
+ *         past the last stage, or NULL if a stage is empty
+ */
+static size_t *split_pipeline(info_t *info, int *n)
+{
+    token_t *t = info->tokens.v;
+    size_t *stages, i;
+    int k;
+
+    for (*n = 1, i = info->tok_start; i < info->tok_end; i++)
+        if (t[i].kind == TOK_PIPE)
+            (*n)++;
+    stages = malloc(sizeof(size_t) * (*n + 1));
+    if (!stages)
+        return (NULL);
+    stages[0] = info->tok_start;
+    for (k = 1, i = info->tok_start; i < info->tok_end; i++)
+        if (t[i].kind == TOK_PIPE)
+            stages[k++] = i + 1;
+    stages[k] = info->tok_end + 1;
+    for (k = 0; k < *n; k++)
+        if (stages[k + 1] - 1 == stages[k])
+        {
+            syntax_error(info, "\"|\" unexpected");
+            return (free(stages), NULL);
+        }
+    return (stages);
+}
+
+/**
+ * run_builtin_stage - runs a builtin as a pipeline stage in a subshell
+ * @info: the parameter & return info struct
+ * @func: the builtin function
+ * @fd_in: descriptor to read from, or -1
+ * @fds: the pipe this stage writes to, or {-1, -1} for the last stage
+ * @pgid: process group to put the subshell in (0 for a new one), or -1
+ *
+ * Return: the child pid, or -1 on failure
+ */
+static pid_t run_builtin_stage(info_t *info, int (*func)(info_t *), int fd_in,
+        int fds[2], pid_t pgid)
+{
+    pid_t pid;
+    int ret;
+
+    pid = fork();
+    if (pid > 0 && pgid != -1)
+        setpgid(pid, pgid);
+    if (pid != 0)
+    {
+        if (pid == -1)
+            info->status = 1, perror("fork");
+        return (pid);
+    }
+    if (pgid != -1)
+        setpgid(0, pgid);
+    if (fd_in != -1)
+        dup2(fd_in, STDIN_FILENO), close(fd_in);
+    if (fds[1] != -1)
+        dup2(fds[1], STDOUT_FILENO), close(fds[1]);
+    if (fds[0] != -1)
+        close(fds[0]);
+    ret = func(info);
+    if (ret == -2)
+        ret = info->err_num == -1 ? info->status : info->err_num;
+    stream_flush_all();
+    _exit(ret);
+}
+
+/**
+ * start_stage - starts one stage of a pipeline
+ * @info: the parameter & return info struct, with argv set for the stage
+ * @fd_in: descriptor to read from, or -1
+ * @fds: the pipe this stage writes to, or {-1, -1} for the last stage
+ * @pgid: process group to put the stage in (0 for a new one), or -1
+ *
+ * Redirections of the stage take the place of the pipe ends.
+ *
+ * Return: the child pid, or -1 with info->status set if nothing was started
+ */
+static pid_t start_stage(info_t *info, int fd_in, int fds[2], pid_t pgid)
+{
+    int (*func)(info_t *) = get_builtin(info->argv[0]);
+    char *path = NULL;
+    pid_t pid = -1;
+    int err, std[3], rd[3], out[2];
+
+    if (!func && info->argc)
+    {
+        path = resolve_cmd(info, info->argv[0]);
+        if (!path)
+        {
+            info->status = 127;
+            print_error(info, "not found\n");
+            return (-1);
+        }
+    }
+    if (redir_open(info, rd) == -1)
+        return (-1);
+    std[0] = rd[0] != -1 ? rd[0] : fd_in;
+    std[1] = rd[1] != -1 ? rd[1] : fds[1];
+    std[2] = -1;
+    out[0] = fds[0];
+    out[1] = std[1];
+    if (func)
+        pid = run_builtin_stage(info, func, std[0], out, pgid);
+    else if (path)
+    {
+        err = spawn_cmd(info, path, info->argv, std, pgid, &pid);
+        if (err)
+        {
+            spawn_error(info, err);
+            pid = -1;
+        }
+    }
+    else
+        info->status = 0;
+    redir_close(rd);
+    return (pid);
+}
+
+/**
+ * start_job - records a started background pipeline in the job table
+ * @info: the parameter & return info struct
+ * @pids: pids of the stages, -1 for stages that did not start
+ * @n: number of stages
+ * @cmd: malloc'd command line of the pipeline
+ */
+static void start_job(info_t *info, pid_t *pids, int n, char *cmd)
+{
+    job_t *job;
+    int i, k;
+
+    for (i = _strlen(cmd); i > 0 && is_delim(cmd[i - 1], " \t"); i--)
+        cmd[i - 1] = 0;
+    for (i = k = 0; i < n; i++)
+        if (pids[i] > 0)
+            pids[k++] = pids[i];
+    if (!k)
+    {
+        free(cmd);
+        return;
+    }
+    job = job_add(info, pids, k, pids[0], cmd);
+    info->last_bg_pid = pids[k - 1];
+    info->status = 0;
+    if (job && interactive(info))
+    {
+        _eputchar('[');
+        _eputs(convert_number(job->id, 10, 0));
+        _eputs("] ");
+        _eputs(convert_number(pids[k - 1], 10, 0));
+        _eputchar('\n');
+    }
+}
+
+/**
+ * run_pipeline - runs every stage of a pipeline concurrently
+ * @info: the parameter & return info struct
+ *
+ * The exit status of each stage is kept in info->pipestatus and the
+ * status of the pipeline is the status of its last stage. A pipeline
+ * ending with '&' runs in its own process group and is not waited for;
+ * when the shell is not interactive its stdin is /dev/null.
+ */
+void run_pipeline(info_t *info)
+{
+    char *cmd = NULL;
+    size_t *stages, start = info->tok_start, end = info->tok_end;
+    int n, i, *st, fd_in = -1, fds[2];
+    pid_t *pids, pgid = -1;
+
+    if (info->linecount_flag == 1)
+    {
+        info->line_count++;
+        info->linecount_flag = 0;
+    }
+    if (info->background)
+    {
+        cmd = shell_strdup(info->arg);
+        pgid = 0;
+        if (!interactive(info))
+            fd_in = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    }
+    stages = split_pipeline(info, &n);
+    if (!stages)
+    {
+        free(cmd);
+        if (fd_in != -1)
+            close(fd_in);
+        return;
+    }
+    pids = malloc(sizeof(pid_t) * n);
+    st = malloc(sizeof(int) * n);
+    if (!pids || !st)
+    {
+        free(stages), free(pids), free(st), free(cmd);
+        if (fd_in != -1)
+            close(fd_in);
+        info->status = 1;
+        return;
+    }
+    stream_flush_all();
+    for (i = 0; i < n; i++)
+    {
+        fds[0] = fds[1] = -1;
+        if (i < n - 1 && pipe2(fds, O_CLOEXEC) == -1)
+        {
+            perror("pipe");
+            fds[0] = fds[1] = -1;
+        }
+        info->tok_start = stages[i];
+        info->tok_end = stages[i + 1] - 1;
+        pids[i] = set_info(info) == -1 ? -1
+            : start_stage(info, fd_in, fds, pgid);
+        if (pgid == 0 && pids[i] > 0)
+            pgid = pids[i];
+        st[i] = info->status;
+        info->argv = NULL;
+        info->argc = 0;
+        if (fd_in != -1)
+            close(fd_in);
+        if (fds[1] != -1)
+            close(fds[1]);
+        fd_in = fds[0];
+    }
+    if (info->background)
+    {
+        start_job(info, pids, n, cmd);
+        for (i = 0; i < n; i++)
+            st[i] = 0;
+    }
+    else
+    {
+        for (i = 0; i < n; i++)
+            if (pids[i] > 0)
+                st[i] = wait_cmd(info, pids[i]);
+        info->status = st[n - 1];
+    }
+    free(info->pipestatus);
+    info->pipestatus = st;
+    info->pipe_len = n;
+    info->tok_start = start;
+    info->tok_end = end;
+    free(stages);
+    free(pids);
+}
+#endif
@@ -0,0 +1,114 @@
+#include "shell.h"
+
+#ifndef WINDOWS
+/**
+ * redir_fail - reports a redirection that could not be opened
+ * @info: the parameter struct
+ * @file: the file name
+ *
+ * Return: always -1
+ */
+static int redir_fail(info_t *info, char *file)
+{
+    info->status = 2;
+    _eputs(info->fname);
+    _eputs(": ");
+    print_d(info->line_count, STDERR_FILENO);
+    _eputs(": cannot open ");
+    _eputs(file);
+    _eputs(": ");
+    _eputs(strerror(errno));
+    _eputchar('\n');
+    return (-1);
+}
+
+/**
+ * redir_open - opens the files the current command redirects to
+ * @info: the parameter struct
+ * @fds: set to the descriptors for stdin, stdout and stderr, -1 for
+ *       those that are not redirected
+ *
+ * Return: 0 on success, -1 with an error printed if a file cannot be opened
+ */
+int redir_open(info_t *info, int fds[3])
+{
+    fds[0] = fds[1] = fds[2] = -1;
+    if (info->redir_in)
+    {
+        fds[0] = open(info->redir_in, O_RDONLY | O_CLOEXEC);
+        if (fds[0] == -1)
+            return (redir_fail(info, info->redir_in));
+    }
+    if (info->redir_out)
+    {
+        fds[1] = open(info->redir_out, O_WRONLY | O_CREAT | O_CLOEXEC
+                | (info->redir_append ? O_APPEND : O_TRUNC), 0666);
+        if (fds[1] == -1)
+        {
+            redir_close(fds);
+            return (redir_fail(info, info->redir_out));
+        }
+    }
+    return (0);
+}
+
+/**
+ * redir_close - closes the descriptors opened by redir_open()
+ * @fds: the descriptors, reset to -1
+ */
+void redir_close(int fds[3])
+{
+    int i;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (fds[i] != -1)
+            close(fds[i]);
+        fds[i] = -1;
+    }
+}
+
+/**
+ * redir_push - applies the redirections of a builtin to the shell itself
+ * @info: the parameter struct
+ * @saved: set to copies of the replaced descriptors, for redir_pop()
+ *
+ * Return: 0 on success, -1 if a file cannot be opened
+ */
+int redir_push(info_t *info, int saved[3])
+{
+    int fds[3], i;
+
+    saved[0] = saved[1] = saved[2] = -1;
+    if (!info->redir_in && !info->redir_out)
+        return (0);
+    if (redir_open(info, fds) == -1)
+        return (-1);
+    stream_flush_all();
+    for (i = 0; i < 3; i++)
+        if (fds[i] != -1)
+        {
+            saved[i] = fcntl(i, F_DUPFD_CLOEXEC, 10);
+            dup2(fds[i], i);
+        }
+    redir_close(fds);
+    return (0);
+}
+
+/**
+ * redir_pop - undoes redir_push()
+ * @saved: the descriptors saved by redir_push()
+ */
+void redir_pop(int saved[3])
+{
+    int i;
+
+    stream_flush_all();
+    for (i = 0; i < 3; i++)
+        if (saved[i] != -1)
+        {
+            dup2(saved[i], i);
+            close(saved[i]);
+        }
+}
+#endif
@@ -86,13 +86,28 @@ int shell_main(int argc, char *argv[])
 
     // Initialize locale for better internationalization support
     init_locale();
-    
-    // Display welcome message in the current language
-    if (get_language() == 1) /* LANG_AR */
-        _puts_utf8((char *)get_message(MSG_WELCOME));
-    else
-        _puts((char *)get_message(MSG_WELCOME));
-    _putchar('\n');
+
+#ifndef WINDOWS
+    // hsh --compile FILE...: refresh the compiled form of scripts and exit
+    if (argc >= 2 && !_strcmp(argv[1], "--compile"))
+    {
+        int i;
+
+        info->fname = argv[0];
+        populate_env_list(info);
+        for (fd = 0, i = 2; i < argc; i++)
+            fd |= code_compile(info, argv[i]);
+        if (argc == 2)
+        {
+            _eputs("Usage: ");
+            _eputs(argv[0]);
+            _eputs(" --compile FILE...\n");
+            fd = 2;
+        }
+        _eputchar(BUF_FLUSH);
+        return (fd);
+    }
+#endif
 
 #ifdef WINDOWS
     // Windows specific initialization - already handled in configure_terminal_for_utf8
@@ -108,7 +123,23 @@ int shell_main(int argc, char *argv[])
         : "r" (fd));
 #endif
 
-    if (argc == 2)
+    if (argc >= 2 && !_strcmp(argv[1], "-c"))
+    {
+        // hsh -c CMDS [NAME]: run CMDS as if read from a script named NAME
+        if (argc == 2)
+        {
+            _eputs(argv[0]);
+            _eputs(": -c: option requires an argument\n");
+            _eputchar(BUF_FLUSH);
+            return (2);
+        }
+        info->map = argv[2];
+        info->map_len = _strlen(argv[2]);
+        info->map_borrowed = 1;
+        if (argc > 3)
+            argv += 3;
+    }
+    else if (argc == 2)
     {
         fd = open(argv[1], O_RDONLY);
         if (fd == -1)
@@ -127,8 +158,25 @@ int shell_main(int argc, char *argv[])
             return (EXIT_FAILURE);
         }
         info->readfd = fd;
+        map_input(info);
+    }
+    info->tty = !info->map_borrowed && info->readfd <= 2
+        && isatty(STDIN_FILENO);
+
+    // Display welcome message in the current language, to terminals only
+    if (info->tty)
+    {
+        if (get_language() == 1) /* LANG_AR */
+            _puts_utf8((char *)get_message(MSG_WELCOME));
+        else
+            _puts((char *)get_message(MSG_WELCOME));
+        _putchar('\n');
     }
     populate_env_list(info);
+#ifndef WINDOWS
+    if (info->map && !info->map_borrowed)
+        code_load(info, argv[1]);
+#endif
     read_history(info);
     hsh(info, argv);
     return (EXIT_SUCCESS);
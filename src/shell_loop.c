@@ -11,20 +11,25 @@ int hsh(info_t *info, char **av)
     ssize_t r = 0;
     int builtin_ret = 0;
 
+    info->fname = av[0]; /* names the shell in error messages */
     while (r != -1 && builtin_ret != -2)
     {
         clear_info(info);
+#ifndef WINDOWS
+        jobs_reap(info);
+        jobs_notify(info);
+#endif
         if (interactive(info))
-            print_prompt_utf8(info);
-        _eputchar(BUF_FLUSH);
-        r = get_input(info);
-        if (r != -1)
         {
-            set_info(info, av);
-            builtin_ret = find_builtin(info);
-            if (builtin_ret == -1)
-                find_cmd(info);
+            hist_sync(info);
+            print_prompt_utf8(info);
         }
+        stream_flush_all();
+        r = get_input(info);
+        if (r == INPUT_COMPOUND)
+            builtin_ret = run_compound(info);
+        else if (r != -1)
+            builtin_ret = run_command(info);
         else if (interactive(info))
             _putchar('\n');
         free_info(info, 0);
@@ -42,6 +47,115 @@ int hsh(info_t *info, char **av)
     return (builtin_ret);
 }
 
+/**
+ * run_command - runs the command in the token range of info
+ * @info: the parameter & return info struct
+ *
+ * Return: what find_builtin() returned, -2 if the shell must exit
+ */
+int run_command(info_t *info)
+{
+    int builtin_ret = 0;
+
+    if (is_pipeline(info) || info->background)
+    {
+#ifndef WINDOWS
+        run_pipeline(info);
+#endif
+    }
+    else if (set_info(info) == 0)
+    {
+        info->pipe_len = 0;
+        builtin_ret = find_builtin(info);
+        if (builtin_ret == -1)
+            find_cmd(info);
+    }
+    return (builtin_ret);
+}
+
+/* builtins in the order help lists them; Windows omits the trailing five */
+static const builtin_table builtintbl[] = {
+        {"cd", _mycd, "Change directory"},
+        {"exit", _myexit, "Exit the shell"},
+        {"env", _myenv, "Show environment variables"},
+        {"setenv", _mysetenv, "Set environment variable"},
+        {"unsetenv", _myunsetenv, "Remove environment variable"},
+        {"help", _myhelp, "Display help information"},
+        {"history", _myhistory, "Show command history"},
+        {"alias", _myalias, "Manage command aliases"},
+        {"lang", _mylang, "Change shell language"},
+        {"test", _mytest, "Test UTF-8 and Arabic support"},
+        {"hash", _myhash, "Manage the command location cache"},
+#ifndef WINDOWS
+        {"jobs", _myjobs, "List background jobs"},
+        {"wait", _mywait, "Wait for background jobs"},
+        {"fg", _myfg, "Move a job to the foreground"},
+        {"bg", _mybg, "Resume a stopped job in the background"},
+        {"parallel", _myparallel,
+            "Run a command for each input line in parallel"},
+#endif
+        {NULL, NULL, NULL}
+};
+
+/*
+ * Perfect hash of the builtin names: BUILTIN_HASH() gives every name in
+ * builtintbl a distinct slot, and builtin_slot maps the slot to the
+ * table index plus one (0 for a slot no builtin uses). When adding a
+ * builtin, give it the free slot its hash lands on, or pick new
+ * multipliers that keep all the names apart.
+ */
+#define BUILTIN_SLOTS 32
+#define BUILTIN_MAX_LEN 8
+#define BUILTIN_HASH(s, len) \
+    (((len) + 7 * (unsigned char)(s)[0] \
+      + 10 * (unsigned char)(s)[(len) - 1]) & (BUILTIN_SLOTS - 1))
+
+static const unsigned char builtin_slot[BUILTIN_SLOTS] = {
+        [31] = 1, [15] = 2, [2] = 3, [7] = 4, [23] = 5, [28] = 6,
+        [25] = 7, [10] = 8, [30] = 9, [24] = 10, [12] = 11,
+#ifndef WINDOWS
+        [8] = 12, [13] = 13, [18] = 14, [22] = 15, [16] = 16,
+#endif
+};
+
+/**
+ * builtin_list - returns the table of builtins
+ *
+ * Used by help to list the builtins with their descriptions.
+ *
+ * Return: the table, terminated by an entry with a NULL name
+ */
+const builtin_table *builtin_list(void)
+{
+    return (builtintbl);
+}
+
+/**
+ * get_builtin - looks up the function implementing a builtin
+ * @name: the command name
+ *
+ * A name is hashed once and compared against at most one builtin, so
+ * commands that are not builtins are rejected without a table scan.
+ *
+ * Return: the builtin function, or NULL if name is not a builtin
+ */
+int (*get_builtin(char *name))(info_t *)
+{
+    size_t len = 0;
+    int i;
+
+    if (!name)
+        return (NULL);
+    while (name[len] && len <= BUILTIN_MAX_LEN)
+        len++;
+    if (!len || len > BUILTIN_MAX_LEN)
+        return (NULL);
+    i = builtin_slot[BUILTIN_HASH(name, len)];
+    if (!i || _strcmp(name, builtintbl[i - 1].type))
+        return (NULL);
+    return (builtintbl[i - 1].func);
+}
+
 /**
  * find_builtin - finds a builtin command
  * @info: the parameter & return info struct
@@ -52,29 +166,24 @@ int hsh(info_t *info, char **av)
  */
 int find_builtin(info_t *info)
 {
-    int i, built_in_ret = -1;
-    builtin_table builtintbl[] = {
-        {"exit", _myexit},
-        {"env", _myenv},
-        {"help", _myhelp},
-        {"history", _myhistory},
-        {"setenv", _mysetenv},
-        {"unsetenv", _myunsetenv},
-        {"cd", _mycd},
-        {"alias", _myalias},
-        {"lang", _mylang},
-        {"test", _mytest},
-        {NULL, NULL}
-    };
-
-    for (i = 0; builtintbl[i].type; i++)
-        if (_strcmp(info->argv[0], builtintbl[i].type) == 0)
-        {
-            info->line_count++;
-            built_in_ret = builtintbl[i].func(info);
-            break;
-        }
-    return (built_in_ret);
+    int (*func)(info_t *) = get_builtin(info->argv[0]);
+    int ret;
+#ifndef WINDOWS
+    int saved[3];
+#endif
+
+    if (!func)
+        return (-1);
+    info->line_count++;
+#ifndef WINDOWS
+    if (redir_push(info, saved) == -1)
+        return (1);
+#endif
+    ret = func(info);
+#ifndef WINDOWS
+    redir_pop(saved);
+#endif
+    return (ret);
 }
 
 /**
@@ -85,7 +194,9 @@ int find_builtin(info_t *info)
 void find_cmd(info_t *info)
 {
     char *path = NULL;
-    int i, k;
+#ifndef WINDOWS
+    int fds[3];
+#endif
 
     info->path = info->argv[0];
     if (info->linecount_flag == 1)
@@ -93,13 +204,17 @@ void find_cmd(info_t *info)
         info->line_count++;
         info->linecount_flag = 0;
     }
-    for (i = 0, k = 0; info->arg[i]; i++)
-        if (!is_delim(info->arg[i], " \t\n"))
-            k++;
-    if (!k)
+    if (!info->argc)
+    {
+#ifndef WINDOWS
+        /* a command of only redirections still creates its files */
+        if (redir_open(info, fds) == 0)
+            redir_close(fds);
+#endif
         return;
+    }
 
-    path = find_path(info, _getenv(info, "PATH="), info->argv[0]);
+    path = hash_find_path(info, info->argv[0]);
     if (path)
     {
         info->path = path;
@@ -110,7 +225,7 @@ void find_cmd(info_t *info)
         if ((interactive(info) || _getenv(info, "PATH=")
                     || info->argv[0][0] == '/') && is_cmd(info, info->argv[0]))
             fork_cmd(info);
-        else if (*(info->arg) != '\n')
+        else
         {
             info->status = 127;
             print_error(info, "not found\n");
@@ -119,7 +234,7 @@ void find_cmd(info_t *info)
 }
 
 /**
- * fork_cmd - forks a an exec thread to run cmd
+ * fork_cmd - spawns a process to run cmd and waits for it
  * @info: the parameter & return info struct
  * Return: void
  */
@@ -167,33 +282,18 @@ void fork_cmd(info_t *info)
     CloseHandle(pi.hThread);
 #else
     pid_t child_pid;
-    int status;
+    int err, fds[3];
 
-    child_pid = fork();
-    if (child_pid == -1)
-    {
-        perror("Error:");
+    if (redir_open(info, fds) == -1)
         return;
-    }
-    if (child_pid == 0)
-    {
-        if (execve(info->path, info->argv, get_environ_copy(info)) == -1)
-        {
-            free_info(info, 1);
-            if (errno == EACCES)
-                exit(126);
-            exit(1);
-        }
-    }
-    else
+    err = spawn_cmd(info, info->path, info->argv, fds, -1, &child_pid);
+    redir_close(fds);
+    if (err)
     {
-        wait(&(info->status));
-        if (WIFEXITED(info->status))
-        {
-            info->status = WEXITSTATUS(info->status);
-            if (info->status == 126)
-                print_error(info, "Permission denied\n");
-        }
+        spawn_error(info, err);
+        return;
     }
+    if (wait_cmd(info, child_pid) == 126)
+        print_error(info, "Permission denied\n");
 #endif
 }
@@ -0,0 +1,106 @@
+#include "shell.h"
+
+#ifndef WINDOWS
+#include <spawn.h>
+
+/**
+ * spawn_cmd - starts a program without duplicating the shell's memory
+ * @info: the parameter & return info struct
+ * @path: path of the program to run
+ * @argv: the argument vector of the program
+ * @fds: descriptors to use as stdin, stdout and stderr, -1 to inherit
+ *       the shell's, or NULL to inherit all three
+ * @pgid: process group to put the child in (0 for a new one), or -1
+ * @pid: address to store the child pid in
+ *
+ * posix_spawn() is implemented with vfork-style process creation, so the
+ * cost of launching does not grow with the size of the shell process.
+ *
+ * Return: 0 on success, otherwise the error number of the failed exec
+ */
+int spawn_cmd(info_t *info, char *path, char **argv, int fds[3], pid_t pgid,
+        pid_t *pid)
+{
+    posix_spawn_file_actions_t fa, *fap = NULL;
+    posix_spawnattr_t attr, *attrp = NULL;
+    int i, err;
+
+    stream_flush_all();
+    if (pgid != -1)
+    {
+        if (posix_spawnattr_init(&attr))
+            return (ENOMEM);
+        attrp = &attr;
+        posix_spawnattr_setflags(attrp, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(attrp, pgid);
+    }
+    if (fds && (fds[0] != -1 || fds[1] != -1 || fds[2] != -1))
+    {
+        if (posix_spawn_file_actions_init(&fa))
+        {
+            if (attrp)
+                posix_spawnattr_destroy(attrp);
+            return (ENOMEM);
+        }
+        fap = &fa;
+        for (i = 0; i < 3; i++)
+            if (fds[i] != -1)
+                posix_spawn_file_actions_adddup2(fap, fds[i], i);
+    }
+    err = posix_spawn(pid, path, fap, attrp, argv, get_environ_copy(info));
+    if (fap)
+        posix_spawn_file_actions_destroy(fap);
+    if (attrp)
+        posix_spawnattr_destroy(attrp);
+    return (err);
+}
+
+/**
+ * wait_cmd - waits for a spawned program and records its exit status
+ * @info: the parameter & return info struct
+ * @pid: the child pid
+ *
+ * Return: the exit status stored in info->status
+ */
+int wait_cmd(info_t *info, pid_t pid)
+{
+    int status;
+
+    while (wait_child(pid, &status, 0) == -1)
+        if (errno != EINTR)
+            return (info->status);
+    info->status = exit_status(status);
+    return (info->status);
+}
+
+/**
+ * exit_status - converts a wait status to a shell exit status
+ * @status: the status reported by waitpid()
+ *
+ * Return: the exit code, or 128 plus the signal number
+ */
+int exit_status(int status)
+{
+    if (WIFEXITED(status))
+        return (WEXITSTATUS(status));
+    if (WIFSIGNALED(status))
+        return (128 + WTERMSIG(status));
+    return (status);
+}
+
+/**
+ * spawn_error - maps a failed spawn to the shell's exit status
+ * @info: the parameter & return info struct
+ * @err: the error number returned by spawn_cmd()
+ */
+void spawn_error(info_t *info, int err)
+{
+    if (err == EACCES)
+    {
+        info->status = 126;
+        print_error(info, "Permission denied\n");
+    }
+    else
+        info->status = 1;
+}
+#endif
@@ -0,0 +1,211 @@
+#include "shell.h"
+
+static stream_t streams[STREAM_MAX];
+
+/**
+ * write_parts - writes several buffers in order, retrying short writes
+ * @fd: the descriptor
+ * @iov: the buffers, consumed as they are written
+ * @n: number of buffers
+ *
+ * All parts go out with a single writev() unless the kernel takes only
+ * part of them.
+ *
+ * Return: 0 on success, -1 on error
+ */
+static int write_parts(int fd, struct iovec *iov, int n)
+{
+    ssize_t w;
+
+    while (n && !iov->iov_len)
+        iov++, n--;
+    while (n)
+    {
+#ifndef WINDOWS
+        w = writev(fd, iov, n);
+#else
+        w = write(fd, iov->iov_base, iov->iov_len);
+#endif
+        if (w == -1 && errno == EINTR)
+            continue;
+        if (w == -1)
+            return (-1);
+        while (n && (size_t)w >= iov->iov_len)
+            w -= iov->iov_len, iov++, n--;
+        if (n)
+        {
+            iov->iov_base = (char *)iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return (0);
+}
+
+/**
+ * stream_get - gets the output stream of a descriptor
+ * @fd: the descriptor
+ *
+ * The buffer is allocated on first use with the size set by
+ * stream_setbuf(), WRITE_BUF_SIZE by default.
+ *
+ * Return: the stream, or NULL if fd is not buffered
+ */
+static stream_t *stream_get(int fd)
+{
+    stream_t *s;
+
+    if (fd < 0 || fd >= STREAM_MAX)
+        return (NULL);
+    s = &streams[fd];
+    if (!s->buf)
+    {
+        if (!s->cap)
+            s->cap = WRITE_BUF_SIZE;
+        s->buf = malloc(s->cap);
+        if (!s->buf)
+            return (NULL);
+    }
+    return (s);
+}
+
+/**
+ * stream_setbuf - sets the buffer size of a descriptor's stream
+ * @fd: the descriptor
+ * @size: the new size in bytes, 0 for WRITE_BUF_SIZE
+ *
+ * Whatever is buffered is written first, and a hold is released.
+ */
+void stream_setbuf(int fd, size_t size)
+{
+    if (fd < 0 || fd >= STREAM_MAX)
+        return;
+    stream_flush(fd);
+    free(streams[fd].buf);
+    streams[fd].buf = NULL;
+    streams[fd].cap = size;
+    streams[fd].held = 0;
+}
+
+/**
+ * stream_hold - keeps stream_flush_all() from writing out a stream
+ * @fd: the descriptor, of a file that nothing reads in step with the shell
+ *
+ * Such a stream is only written when it fills or is flushed by name,
+ * until stream_setbuf() is called on it again.
+ */
+void stream_hold(int fd)
+{
+    if (fd >= 0 && fd < STREAM_MAX)
+        streams[fd].held = 1;
+}
+
+/**
+ * stream_writev - appends several strings to a descriptor's stream
+ * @fd: the descriptor
+ * @parts: the strings; NULL entries are skipped
+ * @n: number of strings
+ *
+ * The parts are copied into the buffer when they all fit. Otherwise the
+ * buffered bytes and the parts are written together with one writev(),
+ * so a message is never split across system calls by the buffer.
+ *
+ * Return: number of bytes taken
+ */
+size_t stream_writev(int fd, const char **parts, int n)
+{
+    stream_t *s = stream_get(fd);
+    struct iovec iov[STREAM_PARTS + 1];
+    size_t len = 0;
+    int i, k = 0;
+
+    if (s && s->len)
+    {
+        iov[k].iov_base = s->buf;
+        iov[k++].iov_len = s->len;
+    }
+    for (i = 0; i < n && k <= STREAM_PARTS; i++)
+        if (parts[i])
+        {
+            iov[k].iov_base = (char *)parts[i];
+            iov[k].iov_len = _strlen((char *)parts[i]);
+            len += iov[k++].iov_len;
+        }
+    if (s && s->len + len <= s->cap)
+    {
+        for (i = s->len ? 1 : 0; i < k; i++)
+        {
+            memcpy(s->buf + s->len, iov[i].iov_base, iov[i].iov_len);
+            s->len += iov[i].iov_len;
+        }
+        return (len);
+    }
+    write_parts(fd, iov, k);
+    if (s)
+        s->len = 0;
+    return (len);
+}
+
+/**
+ * stream_write - appends bytes to a descriptor's stream
+ * @fd: the descriptor
+ * @str: the bytes
+ * @n: number of bytes
+ *
+ * When the bytes do not fit, they are written along with the buffered
+ * ones in a single writev().
+ *
+ * Return: n
+ */
+size_t stream_write(int fd, const char *str, size_t n)
+{
+    stream_t *s = stream_get(fd);
+    struct iovec iov[2];
+
+    if (s && s->len + n <= s->cap)
+    {
+        memcpy(s->buf + s->len, str, n);
+        s->len += n;
+        return (n);
+    }
+    iov[0].iov_base = s ? s->buf : NULL;
+    iov[0].iov_len = s ? s->len : 0;
+    iov[1].iov_base = (char *)str;
+    iov[1].iov_len = n;
+    write_parts(fd, iov, 2);
+    if (s)
+        s->len = 0;
+    return (n);
+}
+
+/**
+ * stream_flush - writes out what a descriptor's stream holds
+ * @fd: the descriptor
+ *
+ * Nothing is written when the stream is empty.
+ */
+void stream_flush(int fd)
+{
+    struct iovec iov;
+
+    if (fd < 0 || fd >= STREAM_MAX || !streams[fd].len)
+        return;
+    iov.iov_base = streams[fd].buf;
+    iov.iov_len = streams[fd].len;
+    streams[fd].len = 0;
+    write_parts(fd, &iov, 1);
+}
+
+/**
+ * stream_flush_all - writes out every stream
+ *
+ * Called before a program is started, so its output cannot overtake the
+ * shell's, and before the shell waits for input. Held streams are left.
+ */
+void stream_flush_all(void)
+{
+    int fd;
+
+    for (fd = 0; fd < STREAM_MAX; fd++)
+        if (!streams[fd].held)
+            stream_flush(fd);
+}
@@ -53,15 +53,21 @@ char *shell_strdup(const char *str)
  */
 void _puts(char *str)
 {
-	int i = 0;
-
 	if (!str)
 		return;
-	while (str[i] != '\0')
-	{
-		_putchar(str[i]);
-		i++;
-	}
+	_putsn(str, _strlen(str));
+}
+
+/**
+ * _putsn - prints n bytes to stdout
+ * @str: the bytes to be printed
+ * @n: number of bytes
+ *
+ * Return: n
+ */
+size_t _putsn(const char *str, size_t n)
+{
+	return (stream_write(STDOUT_FILENO, str, n));
 }
 
 /**
@@ -73,15 +79,9 @@ void _puts(char *str)
  */
 int _putchar(char c)
 {
-	static int i;
-	static char buf[WRITE_BUF_SIZE];
-
-	if (c == BUF_FLUSH || i >= WRITE_BUF_SIZE)
-	{
-		write(1, buf, i);
-		i = 0;
-	}
-	if (c != BUF_FLUSH)
-		buf[i++] = c;
+	if (c == BUF_FLUSH)
+		stream_flush(STDOUT_FILENO);
+	else
+		stream_write(STDOUT_FILENO, &c, 1);
 	return (1);
 }
@@ -2,12 +2,13 @@
 
 /**
  * **strtow - splits a string into words. Repeat delimiters are ignored
+ * @arena: the arena the array and the words are allocated from
  * @str: the input string
  * @d: the delimeter string
  * Return: a pointer to an array of strings, or NULL on failure
  */
 
-char **strtow(char *str, char *d)
+char **strtow(arena_t *arena, char *str, char *d)
 {
 	int i, j, k, m, numwords = 0;
 	char **s;
@@ -22,7 +23,7 @@ char **strtow(char *str, char *d)
 
 	if (numwords == 0)
 		return (NULL);
-	s = malloc((1 + numwords) * sizeof(char *));
+	s = arena_alloc(arena, (1 + numwords) * sizeof(char *));
 	if (!s)
 		return (NULL);
 	for (i = 0, j = 0; j < numwords; j++)
@@ -32,14 +33,9 @@ char **strtow(char *str, char *d)
 		k = 0;
 		while (!is_delim(str[i + k], d) && str[i + k])
 			k++;
-		s[j] = malloc((k + 1) * sizeof(char));
+		s[j] = arena_alloc(arena, (k + 1) * sizeof(char));
 		if (!s[j])
-		{
-			for (k = 0; k < j; k++)
-				free(s[k]);
-			free(s);
 			return (NULL);
-		}
 		for (m = 0; m < k; m++)
 			s[j][m] = str[i++];
 		s[j][m] = 0;
@@ -28,26 +28,28 @@ int get_utf8_char_length(char first_byte)
  */
 int set_text_direction(int is_rtl)
 {
+    if (!isatty(STDOUT_FILENO))
+        return 0; /* the escapes below only mean something to a terminal */
 #ifdef _WIN32
     /* Windows console doesn't natively support RTL, but we can use ANSI escape sequences */
     if (is_rtl) {
         /* Set RTL mode using ANSI escape sequence */
-        write(STDOUT_FILENO, "\033[?7l", 5); /* Disable line wrapping */
+        _putsn("\033[?7l", 5); /* Disable line wrapping */
         /* Additional RTL setup could be added here */
     } else {
         /* Set LTR mode using ANSI escape sequence */
-        write(STDOUT_FILENO, "\033[?7h", 5); /* Enable line wrapping */
+        _putsn("\033[?7h", 5); /* Enable line wrapping */
         /* Additional LTR setup could be added here */
     }
 #else
     /* For Unix/Linux systems with proper terminal support */
     if (is_rtl) {
         /* Set RTL mode */
-        write(STDOUT_FILENO, "\033[?7l", 5); /* Disable line wrapping */
+        _putsn("\033[?7l", 5); /* Disable line wrapping */
         /* Additional RTL setup could be added here */
     } else {
         /* Set LTR mode */
-        write(STDOUT_FILENO, "\033[?7h", 5); /* Enable line wrapping */
+        _putsn("\033[?7h", 5); /* Enable line wrapping */
         /* Additional LTR setup could be added here */
     }
 #endif
@@ -232,4 +234,168 @@ void configure_terminal_for_utf8(void)
     /* Set locale to use UTF-8 */
     setlocale(LC_ALL, "en_US.UTF-8");
 #endif
-} 
\ No newline at end of file
+} 
+/* vector kernels need GCC or Clang for __builtin_ctz and target("avx2") */
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+#define UTF8_SSE2 1
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define UTF8_AVX2 1
+#endif
+#endif
+
+/**
+ * ascii_len_scalar - measures the leading ASCII bytes eight at a time
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * Return: number of bytes before the first one with its high bit set
+ */
+static size_t ascii_len_scalar(const char *s, size_t n)
+{
+    unsigned long long w;
+    size_t i = 0;
+
+    for (; i + 8 <= n; i += 8)
+    {
+        memcpy(&w, s + i, 8);
+        if (w & 0x8080808080808080ULL)
+            break;
+    }
+    while (i < n && !(s[i] & 0x80))
+        i++;
+    return (i);
+}
+
+#ifdef UTF8_SSE2
+/**
+ * ascii_len_sse2 - measures the leading ASCII bytes sixteen at a time
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * Return: number of bytes before the first one with its high bit set
+ */
+static size_t ascii_len_sse2(const char *s, size_t n)
+{
+    size_t i = 0;
+    int m;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        m = _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(s + i)));
+        if (m)
+            return (i + __builtin_ctz(m));
+    }
+    return (i + ascii_len_scalar(s + i, n - i));
+}
+#endif
+
+#ifdef UTF8_AVX2
+/**
+ * ascii_len_avx2 - measures the leading ASCII bytes 32 at a time
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * Only called once the CPU is known to support AVX2.
+ *
+ * Return: number of bytes before the first one with its high bit set
+ */
+__attribute__((target("avx2")))
+static size_t ascii_len_avx2(const char *s, size_t n)
+{
+    size_t i = 0;
+    unsigned int m;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        m = _mm256_movemask_epi8(
+                _mm256_loadu_si256((const __m256i *)(s + i)));
+        if (m)
+            return (i + __builtin_ctz(m));
+    }
+    return (i + ascii_len_sse2(s + i, n - i));
+}
+#endif
+
+/**
+ * utf8_ascii_len - measures the ASCII bytes at the start of a buffer
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * The widest kernel the CPU supports is picked on the first call: AVX2,
+ * then SSE2, then a portable one that tests eight bytes per word.
+ *
+ * Return: number of bytes before the first one with its high bit set
+ */
+size_t utf8_ascii_len(const char *s, size_t n)
+{
+    static size_t (*kernel)(const char *, size_t);
+
+    if (!kernel)
+    {
+        kernel = ascii_len_scalar;
+#ifdef UTF8_SSE2
+        kernel = ascii_len_sse2;
+#endif
+#ifdef UTF8_AVX2
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+            kernel = ascii_len_avx2;
+#endif
+    }
+    return (kernel(s, n));
+}
+
+/**
+ * utf8_valid_len - measures the well-formed UTF-8 at the start of a buffer
+ * @s: the bytes
+ * @n: number of bytes
+ *
+ * Runs of ASCII are skipped by utf8_ascii_len(); only the multibyte
+ * characters between them are decoded. Overlong forms, surrogates, code
+ * points above U+10FFFF and characters cut off by the end of the buffer
+ * all end the valid prefix.
+ *
+ * Return: number of bytes up to the end of s or its first bad byte
+ */
+size_t utf8_valid_len(const char *s, size_t n)
+{
+    const unsigned char *u = (const unsigned char *)s;
+    unsigned char lo, hi;
+    size_t i = 0;
+    int k;
+
+    while (1)
+    {
+        i += utf8_ascii_len(s + i, n - i);
+        if (i == n)
+            return (i);
+        lo = 0x80, hi = 0xBF;
+        if (u[i] >= 0xC2 && u[i] <= 0xDF)
+            k = 2;
+        else if (u[i] >= 0xE0 && u[i] <= 0xEF)
+        {
+            k = 3;
+            if (u[i] == 0xE0)
+                lo = 0xA0; /* overlong */
+            else if (u[i] == 0xED)
+                hi = 0x9F; /* surrogates */
+        }
+        else if (u[i] >= 0xF0 && u[i] <= 0xF4)
+        {
+            k = 4;
+            if (u[i] == 0xF0)
+                lo = 0x90; /* overlong */
+            else if (u[i] == 0xF4)
+                hi = 0x8F; /* above U+10FFFF */
+        }
+        else
+            return (i);
+        if (n - i < (size_t)k || u[i + 1] < lo || u[i + 1] > hi
+                || (k > 2 && (u[i + 2] & 0xC0) != 0x80)
+                || (k > 3 && (u[i + 3] & 0xC0) != 0x80))
+            return (i);
+        i += k;
+    }
+}
@@ -1,5 +1,38 @@
 #include "shell.h"
 
+/**
+ * utf8_write - prints a UTF-8 string to a buffered descriptor
+ * @str: the string to be printed
+ * @fd: the file descriptor to write to
+ *
+ * Well-formed runs, found by utf8_valid_len(), are appended to the buffer
+ * of fd in one copy each and every malformed byte is replaced with '?'.
+ * Nothing is written until the buffer fills or is flushed.
+ *
+ * Return: the number of bytes printed
+ */
+static size_t utf8_write(char *str, int fd)
+{
+    size_t (*put)(const char *, size_t) = fd == STDOUT_FILENO ? _putsn
+        : fd == STDERR_FILENO ? _eputsn : NULL;
+    size_t len = _strlen(str), n, total = 0;
+
+    while (len)
+    {
+        n = utf8_valid_len(str, len);
+        total += put ? put(str, n) : _putfdn(str, n, fd);
+        str += n;
+        len -= n;
+        if (len)
+        {
+            total += put ? put("?", 1) : _putfdn("?", 1, fd);
+            str++;
+            len--;
+        }
+    }
+    return (total);
+}
+
 /**
  * _puts_utf8 - prints a UTF-8 string with proper handling
  * @str: the string to be printed
@@ -8,41 +41,15 @@
  */
 void _puts_utf8(char *str)
 {
-    int i = 0;
-    int char_length;
     int is_rtl = (get_language() == 1); /* Check if we're in RTL mode */
 
     if (!str)
         return;
-    
-    /* If in RTL mode, add RTL mark at the beginning */
-    if (is_rtl) {
-        write(STDOUT_FILENO, "\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
-    }
-    
-    while (str[i] != '\0')
-    {
-        char_length = get_utf8_char_length(str[i]);
-        
-        /* Check if we have a complete UTF-8 character */
-        if (i + char_length <= _strlen(str))
-        {
-            /* Write the complete UTF-8 character */
-            write(1, &str[i], char_length);
-            i += char_length;
-        }
-        else
-        {
-            /* Incomplete UTF-8 character, write a replacement character */
-            _putchar('?');
-            i++;
-        }
-    }
-    
-    /* If in RTL mode, add pop directional formatting at the end */
-    if (is_rtl) {
-        write(STDOUT_FILENO, "\xE2\x80\x8C", 3); /* Pop Directional Formatting (U+200C) */
-    }
+    if (is_rtl)
+        _putsn("\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
+    utf8_write(str, STDOUT_FILENO);
+    if (is_rtl)
+        _putsn("\xE2\x80\x8C", 3); /* Pop Directional Formatting (U+200C) */
 }
 
 /**
@@ -53,30 +60,8 @@ void _puts_utf8(char *str)
  */
 void _eputs_utf8(char *str)
 {
-    int i = 0;
-    int char_length;
-
-    if (!str)
-        return;
-    
-    while (str[i] != '\0')
-    {
-        char_length = get_utf8_char_length(str[i]);
-        
-        /* Check if we have a complete UTF-8 character */
-        if (i + char_length <= _strlen(str))
-        {
-            /* Write the complete UTF-8 character */
-            write(2, &str[i], char_length);
-            i += char_length;
-        }
-        else
-        {
-            /* Incomplete UTF-8 character, write a replacement character */
-            _eputchar('?');
-            i++;
-        }
-    }
+    if (str)
+        utf8_write(str, STDERR_FILENO);
 }
 
 /**
@@ -88,33 +73,9 @@ void _eputs_utf8(char *str)
  */
 int _putsfd_utf8(char *str, int fd)
 {
-    int i = 0;
-    int bytes_written = 0;
-    int char_length;
-
     if (!str)
         return (0);
-    
-    while (str[i] != '\0')
-    {
-        char_length = get_utf8_char_length(str[i]);
-        
-        /* Check if we have a complete UTF-8 character */
-        if (i + char_length <= _strlen(str))
-        {
-            /* Write the complete UTF-8 character */
-            bytes_written += write(fd, &str[i], char_length);
-            i += char_length;
-        }
-        else
-        {
-            /* Incomplete UTF-8 character, write a replacement character */
-            bytes_written += _putfd('?', fd);
-            i++;
-        }
-    }
-    
-    return bytes_written;
+    return (utf8_write(str, fd));
 }
 
 /**
@@ -138,14 +99,14 @@ void print_prompt_utf8(info_t *info)
         {
             /* For Arabic, use UTF-8 aware output with RTL direction */
             /* Add special RTL marker for better rendering */
-            write(STDOUT_FILENO, "\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
+            _putsn("\xE2\x80\x8F", 3); /* RTL mark (U+200F) */
             _puts_utf8((char *)prompt);
         }
         else
         {
             /* For English, use regular output with LTR direction */
             /* Add special LTR marker for better rendering */
-            write(STDOUT_FILENO, "\xE2\x80\x8E", 3); /* LTR mark (U+200E) */
+            _putsn("\xE2\x80\x8E", 3); /* LTR mark (U+200E) */
             _puts((char *)prompt);
         }
     }
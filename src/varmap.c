@@ -0,0 +1,337 @@
+#include "shell.h"
+
+/* slot markers of the open addressing index */
+#define SLOT_EMPTY -1
+#define SLOT_DELETED -2
+
+/**
+ * var_hash - computes the FNV-1a hash of a variable name
+ * @name: the name
+ * @len: length of the name
+ *
+ * Return: the hash value
+ */
+static unsigned int var_hash(const char *name, size_t len)
+{
+    unsigned int h = 2166136261u;
+
+    while (len--)
+        h = (h ^ (unsigned char)*name++) * 16777619u;
+    return (h);
+}
+
+/**
+ * var_keylen - gets the length of the NAME part of a NAME=value string
+ * @str: the string
+ *
+ * Return: number of bytes before the first '='
+ */
+static size_t var_keylen(const char *str)
+{
+    size_t n = 0;
+
+    while (str[n] && str[n] != '=')
+        n++;
+    return (n);
+}
+
+/**
+ * varmap_rehash - rebuilds the index, dropping deleted entries
+ * @map: the map
+ * @nslots: new number of index slots, a power of two
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int varmap_rehash(var_map_t *map, size_t nslots)
+{
+    int *slots;
+    size_t i, j, s;
+
+    slots = malloc(sizeof(int) * nslots);
+    if (!slots)
+        return (-1);
+    for (s = 0; s < nslots; s++)
+        slots[s] = SLOT_EMPTY;
+    for (i = j = 0; i < map->count; i++)
+    {
+        if (!map->entries[i].str)
+            continue;
+        map->entries[j] = map->entries[i];
+        s = map->entries[j].hash & (nslots - 1);
+        while (slots[s] != SLOT_EMPTY)
+            s = (s + 1) & (nslots - 1);
+        slots[s] = j++;
+    }
+    map->count = map->live = j;
+    free(map->slots);
+    map->slots = slots;
+    map->nslots = nslots;
+    return (0);
+}
+
+/**
+ * varmap_slot - finds the index slot of a name
+ * @map: the map
+ * @name: the name, not necessarily NUL terminated
+ * @len: length of the name
+ *
+ * Return: the slot holding the name, or -1 if the name is not in the map
+ */
+static long varmap_slot(var_map_t *map, const char *name, size_t len)
+{
+    unsigned int h = var_hash(name, len);
+    size_t s;
+    var_entry_t *e;
+
+    if (!map->nslots)
+        return (-1);
+    for (s = h & (map->nslots - 1); map->slots[s] != SLOT_EMPTY;
+            s = (s + 1) & (map->nslots - 1))
+    {
+        if (map->slots[s] == SLOT_DELETED)
+            continue;
+        e = &map->entries[map->slots[s]];
+        if (e->hash == h && e->keylen == len && !strncmp(e->str, name, len))
+            return (s);
+    }
+    return (-1);
+}
+
+/**
+ * varmap_find - finds the entry of a variable
+ * @map: the map
+ * @name: the name, not necessarily NUL terminated
+ * @len: length of the name
+ *
+ * Return: the entry, or NULL if the variable is not set
+ */
+var_entry_t *varmap_find(var_map_t *map, const char *name, size_t len)
+{
+    long s = varmap_slot(map, name, len);
+
+    return (s == -1 ? NULL : &map->entries[map->slots[s]]);
+}
+
+/**
+ * varmap_grow_vec - doubles the capacity of a map's string vector
+ * @map: the map
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int varmap_grow_vec(var_map_t *map)
+{
+    size_t cap = map->vec_cap ? map->vec_cap * 2 : 64;
+    char **vec = realloc(map->vec, sizeof(char *) * cap);
+
+    if (!vec)
+        return (-1);
+    if (!map->vec)
+        vec[0] = NULL;
+    map->vec = vec;
+    map->vec_cap = cap;
+    return (0);
+}
+
+/**
+ * varmap_put - adds a NAME=value string, replacing any entry of that name
+ * @map: the map
+ * @str: the NAME=value string
+ * @borrowed: 1 if str must never be freed by the map
+ *
+ * A replaced variable keeps its position in the insertion order.
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+static int varmap_put(var_map_t *map, char *str, int borrowed)
+{
+    size_t len = var_keylen(str), cap, s;
+    var_entry_t *e = varmap_find(map, str, len), *entries;
+
+    if (e)
+    {
+        if (!e->borrowed)
+            free(e->str);
+        e->str = str;
+        e->borrowed = borrowed;
+        map->vec[e->vpos] = str;
+        return (0);
+    }
+    if (map->live + 2 > map->vec_cap && varmap_grow_vec(map) == -1)
+        return (-1);
+    if (map->count == map->cap)
+    {
+        cap = map->cap ? map->cap * 2 : 64;
+        entries = realloc(map->entries, sizeof(var_entry_t) * cap);
+        if (!entries)
+            return (-1);
+        map->entries = entries;
+        map->cap = cap;
+    }
+    if ((map->count + 1) * 2 > map->nslots
+            && varmap_rehash(map, map->nslots ? map->nslots * 2 : 128) == -1)
+        return (-1);
+    e = &map->entries[map->count];
+    e->str = str;
+    e->keylen = len;
+    e->hash = var_hash(str, len);
+    e->vpos = map->live;
+    e->borrowed = borrowed;
+    map->vec[map->live] = str;
+    map->vec[map->live + 1] = NULL;
+    for (s = e->hash & (map->nslots - 1); map->slots[s] >= 0;
+            s = (s + 1) & (map->nslots - 1))
+        ;
+    map->slots[s] = map->count++;
+    map->live++;
+    return (0);
+}
+
+/**
+ * varmap_set - adds a NAME=value string, replacing any entry of that name
+ * @map: the map
+ * @str: malloc'd NAME=value string, owned by the map afterwards
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+int varmap_set(var_map_t *map, char *str)
+{
+    return (varmap_put(map, str, 0));
+}
+
+/**
+ * varmap_import - adds every string of a vector without copying them
+ * @map: the map, normally still empty
+ * @strs: NULL terminated vector of NAME=value strings that outlive the map
+ *
+ * The strings are referenced in place and are only replaced, never
+ * modified or freed, when a variable is later set or unset. The map is
+ * sized once up front so importing does not grow it repeatedly.
+ *
+ * Return: 0 on success, -1 on allocation failure
+ */
+int varmap_import(var_map_t *map, char **strs)
+{
+    size_t n = 0, i, nslots = 128;
+    var_entry_t *entries;
+    char **vec;
+
+    while (strs && strs[n])
+        n++;
+    if (map->cap < map->count + n)
+    {
+        entries = realloc(map->entries, sizeof(var_entry_t) * (map->count + n));
+        if (!entries)
+            return (-1);
+        map->entries = entries;
+        map->cap = map->count + n;
+    }
+    if (map->vec_cap < map->live + n + 1)
+    {
+        vec = realloc(map->vec, sizeof(char *) * (map->live + n + 1));
+        if (!vec)
+            return (-1);
+        vec[map->live] = NULL;
+        map->vec = vec;
+        map->vec_cap = map->live + n + 1;
+    }
+    while (nslots < (map->count + n) * 2)
+        nslots *= 2;
+    if (nslots > map->nslots && varmap_rehash(map, nslots) == -1)
+        return (-1);
+    for (i = 0; i < n; i++)
+        if (varmap_put(map, strs[i], 1) == -1)
+            return (-1);
+    return (0);
+}
+
+/**
+ * varmap_unset - removes a variable
+ * @map: the map
+ * @name: the name, not necessarily NUL terminated
+ * @len: length of the name
+ *
+ * Return: 1 if the variable was removed, 0 if it was not set
+ */
+int varmap_unset(var_map_t *map, const char *name, size_t len)
+{
+    long s = varmap_slot(map, name, len);
+    var_entry_t *e, *moved;
+    char *last;
+
+    if (s == -1)
+        return (0);
+    e = &map->entries[map->slots[s]];
+    map->slots[s] = SLOT_DELETED;
+    map->live--;
+    last = map->vec[map->live];
+    if (e->vpos != map->live)
+    {
+        moved = varmap_find(map, last, var_keylen(last));
+        moved->vpos = e->vpos;
+        map->vec[e->vpos] = last;
+    }
+    map->vec[map->live] = NULL;
+    if (!e->borrowed)
+        free(e->str);
+    e->str = NULL;
+    if (map->count > 64 && map->live < map->count / 2)
+        varmap_rehash(map, map->nslots);
+    return (1);
+}
+
+/**
+ * varmap_free - frees every entry of a map
+ * @map: the map
+ */
+void varmap_free(var_map_t *map)
+{
+    size_t i;
+
+    for (i = 0; i < map->count; i++)
+        if (!map->entries[i].borrowed)
+            free(map->entries[i].str);
+    free(map->entries);
+    free(map->slots);
+    free(map->vec);
+    map->entries = NULL;
+    map->slots = NULL;
+    map->vec = NULL;
+    map->count = map->live = map->cap = map->nslots = map->vec_cap = 0;
+}
+
+/**
+ * varmap_print - prints the entries of a map in insertion order
+ * @map: the map
+ *
+ * Return: number of entries printed
+ */
+size_t varmap_print(var_map_t *map)
+{
+    size_t i, n = 0;
+
+    for (i = 0; i < map->count; i++)
+        if (map->entries[i].str)
+        {
+            _puts(map->entries[i].str);
+            _putchar('\n');
+            n++;
+        }
+    return (n);
+}
+
+/**
+ * varmap_vector - returns the NULL terminated vector of a map's strings
+ * @map: the map
+ *
+ * The vector is kept up to date by varmap_set() and varmap_unset() and
+ * shares its strings with the map, so it must not be modified or freed.
+ * Its order is the insertion order until a variable is unset.
+ *
+ * Return: the vector, never NULL
+ */
+char **varmap_vector(var_map_t *map)
+{
+    static char *empty[] = {NULL};
+
+    return (map->vec ? map->vec : empty);
+}
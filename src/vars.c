@@ -1,158 +1,161 @@
 #include "shell.h"
 
 /**
- * is_chain - test if current char in buffer is a chain delimeter
+ * expand_alias - computes the full expansion of an alias
  * @info: the parameter struct
- * @buf: the char buffer
- * @p: address of current position in buf
+ * @name: the alias name
  *
- * Return: 1 if chain delimeter, 0 otherwise
- */
-int is_chain(info_t *info, char *buf, size_t *p)
-{
-    size_t j = *p;
-
-    if (buf[j] == '|' && buf[j + 1] == '|')
-    {
-        buf[j] = 0;
-        j++;
-        info->cmd_buf_type = CMD_OR;
-    }
-    else if (buf[j] == '&' && buf[j + 1] == '&')
-    {
-        buf[j] = 0;
-        j++;
-        info->cmd_buf_type = CMD_AND;
-    }
-    else if (buf[j] == ';') /* found end of this command */
-    {
-        buf[j] = 0; /* replace semicolon with null */
-        info->cmd_buf_type = CMD_CHAIN;
-    }
-    else
-        return (0);
-    *p = j;
-    return (1);
-}
-
-/**
- * check_chain - checks we should continue chaining based on last status
- * @info: the parameter struct
- * @buf: the char buffer
- * @p: address of current position in buf
- * @i: starting position in buf
- * @len: length of buf
+ * The first word of an alias value is itself looked up as an alias until
+ * it is not one or names an alias already expanded in this chain, so
+ * cycles such as "alias ls=ls -F" end instead of looping.
  *
- * Return: Void
+ * Return: malloc'd NAME=words string, or NULL if name is not an alias
  */
-void check_chain(info_t *info, char *buf, size_t *p, size_t i, size_t len)
+static char *expand_alias(info_t *info, char *name)
 {
-    size_t j = *p;
+    var_entry_t *e, **seen = NULL, **tmp;
+    size_t n = 0, cap = 0, i, len;
+    char *word = name, *rest = NULL, *val, *p, *q;
+    int wlen = _strlen(name);
 
-    if (info->cmd_buf_type == CMD_AND)
+    while ((e = varmap_find(&(info->alias), word, wlen)))
     {
-        if (info->status)
+        for (i = 0; i < n && seen[i] != e; i++)
+            ;
+        if (i < n)
+            break;
+        if (n == cap)
         {
-            buf[i] = 0;
-            j = len;
+            cap = cap ? cap * 2 : 8;
+            tmp = realloc(seen, sizeof(*seen) * cap);
+            if (!tmp)
+                break;
+            seen = tmp;
         }
-    }
-    if (info->cmd_buf_type == CMD_OR)
-    {
-        if (!info->status)
+        seen[n++] = e;
+        val = e->str + e->keylen + 1;
+        while (is_delim(*val, " \t"))
+            val++;
+        for (p = val; *p && !is_delim(*p, " \t"); p++)
+            ;
+        if (*p)
         {
-            buf[i] = 0;
-            j = len;
+            len = _strlen(p) + (rest ? _strlen(rest) + 1 : 0);
+            q = malloc(len + 1);
+            if (!q)
+                break;
+            _strcpy(q, p);
+            if (rest)
+                _strcat(q, " "), _strcat(q, rest);
+            free(rest);
+            rest = q;
         }
+        word = val;
+        wlen = p - val;
     }
-
-    *p = j;
+    free(seen);
+    if (!n)
+        return (NULL);
+    len = _strlen(name) + wlen + (rest ? _strlen(rest) : 0) + 2;
+    p = malloc(len + 1);
+    if (p)
+    {
+        _strcpy(p, name);
+        _strcat(p, "=");
+        _strncat(p, word, wlen);
+        p[_strlen(name) + 1 + wlen] = 0;
+        if (rest)
+            _strcat(p, " "), _strcat(p, rest);
+    }
+    free(rest);
+    return (p);
 }
 
 /**
- * replace_alias - replaces an aliases in the tokenized string
+ * alias_value - gets the full expansion of an alias
  * @info: the parameter struct
+ * @name: the command word
  *
- * Return: 1 if replaced, 0 otherwise
+ * Expansions are cached by name in info->alias_cache until an alias is
+ * set or unset.
+ *
+ * Return: the expanded words as one string, or NULL if name is not an alias
  */
-int replace_alias(info_t *info)
+char *alias_value(info_t *info, char *name)
 {
-    int i;
-    list_t *node;
-    char *p;
+    var_entry_t *e;
+    char *str;
+    int len;
 
-    for (i = 0; i < 10; i++)
+    if (!info->alias.live)
+        return (NULL);
+    len = _strlen(name);
+    e = varmap_find(&(info->alias_cache), name, len);
+    if (!e)
     {
-        node = node_starts_with(info->alias, info->argv[0], '=');
-        if (!node)
-            return (0);
-        free(info->argv[0]);
-        p = _strchr(node->str, '=');
-        if (!p)
-            return (0);
-        p = shell_strdup(p + 1);
-        if (!p)
-            return (0);
-        info->argv[0] = p;
+        str = expand_alias(info, name);
+        if (!str)
+            return (NULL);
+        if (varmap_set(&(info->alias_cache), str) == -1)
+            return (free(str), NULL);
+        e = varmap_find(&(info->alias_cache), name, len);
     }
-    return (1);
+    return (e->str + len + 1);
 }
 
 /**
- * replace_vars - replaces vars in the tokenized string
+ * var_value - gets the value a $ expansion stands for
  * @info: the parameter struct
+ * @name: the name after the '$', not necessarily NUL terminated
+ * @len: length of the name
  *
- * Return: 1 if replaced, 0 otherwise
+ * Return: the value, which is only valid until the next call, or NULL
  */
-int replace_vars(info_t *info)
+const char *var_value(info_t *info, const char *name, size_t len)
 {
-    int i = 0;
-    list_t *node;
-
-    for (i = 0; info->argv[i]; i++)
-    {
-        if (info->argv[i][0] != '$' || !info->argv[i][1])
-            continue;
+    var_entry_t *e;
 
-        if (!_strcmp(info->argv[i], "$?"))
-        {
-            replace_string(&(info->argv[i]),
-                shell_strdup(convert_number(info->status, 10, 0)));
-            continue;
-        }
-        if (!_strcmp(info->argv[i], "$$"))
-        {
+    if (len == 1 && *name == '?')
+        return (convert_number(info->status, 10, 0));
+    if (len == 1 && *name == '!')
+        return (info->last_bg_pid
+                ? convert_number(info->last_bg_pid, 10, 0) : NULL);
+    if (len == 1 && *name == '$')
 #ifdef WINDOWS
-            replace_string(&(info->argv[i]),
-                shell_strdup(convert_number(GetCurrentProcessId(), 10, 0)));
+        return (convert_number(GetCurrentProcessId(), 10, 0));
 #else
-            replace_string(&(info->argv[i]),
-                shell_strdup(convert_number(getpid(), 10, 0)));
+        return (convert_number(getpid(), 10, 0));
 #endif
-            continue;
-        }
-        node = node_starts_with(info->env, &info->argv[i][1], '=');
-        if (node)
-        {
-            replace_string(&(info->argv[i]),
-                shell_strdup(_strchr(node->str, '=') + 1));
-            continue;
-        }
-        replace_string(&info->argv[i], shell_strdup(""));
-    }
-    return (0);
+    if (len == 10 && !strncmp(name, "PIPESTATUS", 10))
+        return (pipestatus_string(info));
+    e = varmap_find(&(info->env), name, len);
+    if (e && e->str[e->keylen])
+        return (e->str + e->keylen + 1);
+    return (NULL);
 }
 
 /**
- * replace_string - replaces string
- * @old: address of old string
- * @new: new string
+ * pipestatus_string - formats the exit status of each pipeline stage
+ * @info: the parameter struct
  *
- * Return: 1 if replaced, 0 otherwise
+ * Return: space separated list of statuses, allocated from info->arena
  */
-int replace_string(char **old, char *new)
+char *pipestatus_string(info_t *info)
 {
-    free(*old);
-    *old = new;
-    return (1);
+    char *s, *num;
+    int i, n = info->pipe_len ? info->pipe_len : 1;
+
+    s = arena_alloc(&(info->arena), n * 12);
+    if (!s)
+        return (NULL);
+    *s = 0;
+    for (i = 0; i < n; i++)
+    {
+        num = convert_number(info->pipe_len ? info->pipestatus[i]
+                : info->status, 10, 0);
+        if (i)
+            _strcat(s, " ");
+        _strcat(s, num);
+    }
+    return (s);
 }